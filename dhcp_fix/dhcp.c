@@ -52,6 +52,7 @@
 
 #include "socket.h"
 #include "dhcp.h"
+#include "w5x00_socket.h"
 #include <string.h>
 
 /* If you want to display debug & processing message, Define _DHCP_DEBUG_ in dhcp.h */
@@ -192,6 +193,7 @@ typedef struct {
 
 
 uint8_t DHCP_SOCKET;                      // Socket number for DHCP
+wizchip_socket_snapshot_t DHCP_SOCKET_SNAPSHOT; // State of the DHCP socket, read once per DHCP_run
 
 uint8_t DHCP_SIP[4];                      // DHCP Server IP address
 uint8_t DHCP_REAL_SIP[4];                 // For extract my DHCP server in a few DHCP server
@@ -581,7 +583,7 @@ int8_t parseDHCPMSG(void)
 	uint8_t type = 0;
 	uint8_t opt_len;
 
-   if((len = getSn_RX_RSR(DHCP_SOCKET)) > 0)
+   if((len = DHCP_SOCKET_SNAPSHOT.rx_received_size) > 0)
    {
    	len = recvfrom(DHCP_SOCKET, (uint8_t *)pDHCPMSG, len, svr_addr, &svr_port);
    #ifdef _DHCP_DEBUG_
@@ -698,8 +700,13 @@ uint8_t DHCP_run(void)
 
 	if(dhcp_state == STATE_DHCP_STOP) return DHCP_STOPPED;
 
-	if(getSn_SR(DHCP_SOCKET) != SOCK_UDP)
+	wizchip_socket_snapshot(DHCP_SOCKET, &DHCP_SOCKET_SNAPSHOT);
+
+	if(DHCP_SOCKET_SNAPSHOT.status != SOCK_UDP)
+	{
 	   socket(DHCP_SOCKET, Sn_MR_UDP, DHCP_CLIENT_PORT, 0x00);
+	   wizchip_socket_snapshot(DHCP_SOCKET, &DHCP_SOCKET_SNAPSHOT);
+	}
 
 	ret = DHCP_RUNNING;
 	type = parseDHCPMSG();
@@ -0,0 +1,249 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "types.h"
+#include "command.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Benchmark */
+#define BENCH_COMMANDS 2000000
+#define BENCH_RX_SIZE 2048             // RX buffer of the W5x00 socket
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+typedef struct bench_result_t
+{
+    uint32_t dispatched;
+    uint32_t errors;
+    uint64_t bytes;
+    double seconds;
+} bench_result_t;
+
+typedef bool (*bench_next_t)(const uint8_t *window, uint16_t size, uint16_t *consumed, uint8_t *message_type, int32_t *value);
+
+/* Pipelined requests of a client, unknown commands included */
+static const char *g_stream_commands[] = {"GET#", "SET0#", "SET1#", "SET2#", "SET3#", "HB#", "SPI#", "NOPE#"};
+static uint32_t g_seed;
+
+/* The W5x00 RX buffer and the window of the server on it */
+static uint8_t g_rx[BENCH_RX_SIZE];
+static uint16_t g_rx_size;
+static uint8_t g_window[BUFFER_SIZE];
+static uint16_t g_window_size;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+static uint32_t bench_random(void)
+{
+    g_seed = g_seed * 1103515245 + 12345;
+
+    return g_seed >> 16;
+}
+
+/* Command table through the hash index */
+static bool bench_next_table(const uint8_t *window, uint16_t size, uint16_t *consumed, uint8_t *message_type, int32_t *value)
+{
+    const command_t *command;
+
+    if (!command_next(window, size, BUFFER_SIZE, consumed, &command, value))
+    {
+        return false;
+    }
+
+    *message_type = command->message_type;
+
+    return true;
+}
+
+/* Before: a strcmp per known command */
+static bool bench_next_strcmp(const uint8_t *window, uint16_t size, uint16_t *consumed, uint8_t *message_type, int32_t *value)
+{
+    static const struct
+    {
+        const char *name;
+        uint8_t message_type;
+        int32_t value;
+    } chain[] = {{"GET", MSG_GET_STATUS, 0}, {"SET0", MSG_SET_SPEED, 0}, {"SET1", MSG_SET_SPEED, 1}, {"SET2", MSG_SET_SPEED, 2},
+                 {"SET3", MSG_SET_SPEED, 3}, {"HB", MSG_KEEPALIVE, 0}, {"SPI", MSG_SPI_STATS, 0}, {"BIN", MSG_BINARY, 0}};
+    char name[BUFFER_SIZE];
+
+    while (*consumed < size)
+    {
+        const uint8_t *start = window + *consumed;
+        const uint8_t *end = memchr(start, '#', size - *consumed);
+
+        if (!end)
+        {
+            if (*consumed == 0 && size == BUFFER_SIZE)
+            {
+                *consumed = size;
+            }
+            return false;
+        }
+
+        *consumed = end - window + 1;
+        memcpy(name, start, end - start);
+        name[end - start] = 0;
+
+        for (uint8_t i = 0; i < sizeof(chain) / sizeof(chain[0]); i++)
+        {
+            if (!strcmp(name, chain[i].name))
+            {
+                *message_type = chain[i].message_type;
+                *value = chain[i].value;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/* What a client command is expected to dispatch, false for an unknown one */
+static bool bench_expect(const char *text, uint8_t *message_type, int32_t *value)
+{
+    if (!strcmp(text, "GET#")) { *message_type = MSG_GET_STATUS; *value = 0; return true; }
+    if (!strncmp(text, "SET", 3)) { *message_type = MSG_SET_SPEED; *value = text[3] - '0'; return true; }
+    if (!strcmp(text, "HB#")) { *message_type = MSG_KEEPALIVE; *value = 0; return true; }
+    if (!strcmp(text, "SPI#")) { *message_type = MSG_SPI_STATS; *value = 0; return true; }
+
+    return false;
+}
+
+/* Random segments of 1 to segment_max bytes, every segment is followed by one server pass */
+static bench_result_t bench_run(bench_next_t next, uint16_t segment_max)
+{
+    bench_result_t result = {0};
+    uint8_t expected_type[BENCH_RX_SIZE];
+    int32_t expected_value[BENCH_RX_SIZE];
+    uint32_t expected_put = 0;
+    uint32_t expected_get = 0;
+    uint8_t stream[BENCH_RX_SIZE];
+    uint16_t stream_size = 0;
+    uint32_t sent = 0;
+
+    g_seed = segment_max;
+    g_rx_size = 0;
+    g_window_size = 0;
+
+    clock_t start = clock();
+
+    while (sent < BENCH_COMMANDS || stream_size > 0 || g_rx_size > 0)
+    {
+        // The client pipelines commands without waiting for replies
+        while (sent < BENCH_COMMANDS && stream_size < BENCH_RX_SIZE / 2)
+        {
+            const char *text = g_stream_commands[bench_random() % (sizeof(g_stream_commands) / sizeof(g_stream_commands[0]))];
+
+            memcpy(stream + stream_size, text, strlen(text));
+            stream_size += strlen(text);
+            sent++;
+
+            if (bench_expect(text, &expected_type[expected_put % BENCH_RX_SIZE], &expected_value[expected_put % BENCH_RX_SIZE]))
+            {
+                expected_put++;
+            }
+        }
+
+        // One TCP segment into the RX buffer, as far as the window of the socket allows
+        uint16_t segment = 1 + bench_random() % segment_max;
+        if (segment > stream_size)
+        {
+            segment = stream_size;
+        }
+        if (segment > BENCH_RX_SIZE - g_rx_size)
+        {
+            segment = BENCH_RX_SIZE - g_rx_size;
+        }
+
+        memcpy(g_rx + g_rx_size, stream, segment);
+        g_rx_size += segment;
+        memmove(stream, stream + segment, stream_size - segment);
+        stream_size -= segment;
+        result.bytes += segment;
+
+        // Server pass: peek behind the window, dispatch every complete command, release them
+        uint16_t peek = g_rx_size - g_window_size;
+        if (peek > BUFFER_SIZE - g_window_size)
+        {
+            peek = BUFFER_SIZE - g_window_size;
+        }
+        memcpy(g_window + g_window_size, g_rx + g_window_size, peek);
+        g_window_size += peek;
+
+        uint16_t consumed = 0;
+        uint8_t message_type;
+        int32_t value;
+
+        while (next(g_window, g_window_size, &consumed, &message_type, &value))
+        {
+            if (expected_get == expected_put || expected_type[expected_get % BENCH_RX_SIZE] != message_type ||
+                expected_value[expected_get % BENCH_RX_SIZE] != value)
+            {
+                result.errors++;
+            }
+            expected_get++;
+            result.dispatched++;
+        }
+
+        memmove(g_rx, g_rx + consumed, g_rx_size - consumed);
+        g_rx_size -= consumed;
+        memmove(g_window, g_window + consumed, g_window_size - consumed);
+        g_window_size -= consumed;
+    }
+
+    result.seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    result.errors += expected_put - expected_get;
+
+    return result;
+}
+
+static bool bench_print(const char *name, uint16_t segment_max, bench_result_t result)
+{
+    printf(" %-6s, segments of 1 to %3d bytes: %7ld commands dispatched, %ld errors, %6.1f MB/s, %5.1f M commands/s\n",
+           name, segment_max, (long)result.dispatched, (long)result.errors,
+           result.bytes / result.seconds / 1e6, result.dispatched / result.seconds / 1e6);
+
+    return result.errors == 0;
+}
+
+int main(void)
+{
+    static const uint16_t segment_max[] = {1, 7, 64, 512};
+    bool passed = true;
+
+    command_initialize();
+
+    printf("Command framer, %d pipelined commands in random segments\n", BENCH_COMMANDS);
+
+    for (uint8_t i = 0; i < sizeof(segment_max) / sizeof(segment_max[0]); i++)
+    {
+        passed &= bench_print("strcmp", segment_max[i], bench_run(bench_next_strcmp, segment_max[i]));
+        passed &= bench_print("table", segment_max[i], bench_run(bench_next_table, segment_max[i]));
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,278 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "wizchip_conf.h"
+#include "socket.h"
+#include "w5x00_spi.h"
+#include "w5500_sim.h"
+#include "firmware_sim.h"
+#include "server.h"
+#include "message_pool.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Benchmark */
+#define BENCH_CLIENTS 32
+#define BENCH_ARRIVAL_US 2000          // a new client every 2 ms
+#define BENCH_RETRY_US (1000 * 1000)   // SYN retransmission of a refused client
+#define BENCH_SECONDS 120              // simulated time
+#define BENCH_SWEEP_US ((uint64_t)SERVER_SWEEP_TICKS * 1000)
+
+#ifdef SERVER_ADMISSION_REJECT
+#define BENCH_POLICY "new clients refused while the pool is full"
+#else
+#define BENCH_POLICY "longest idle client evicted"
+#endif
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+typedef enum bench_state_t
+{
+    BENCH_CONNECTING,
+    BENCH_CONNECTED,
+    BENCH_EVICTED
+} bench_state_t;
+
+/* A client connects, retries while it is refused and sends its heartbeat until the server closes it */
+typedef struct bench_client_t
+{
+    bench_state_t state;
+    int socket;
+    uint64_t first_attempt_us;
+    uint64_t next_attempt_us;
+    uint64_t next_heartbeat_us;
+} bench_client_t;
+
+typedef struct bench_result_t
+{
+    uint32_t admitted;
+    uint32_t starved;                   // never admitted, their latency counts as the run length
+    uint32_t refused;
+    uint32_t evicted;
+    uint32_t max_concurrent;
+    uint64_t latency_sum_us;
+    uint64_t latency_max_us;
+    uint32_t polls;
+    uint32_t transactions;
+    double seconds;
+} bench_result_t;
+
+static uint64_t g_now_us;
+static uint64_t g_next_sweep_us;
+static bench_client_t g_clients[BENCH_CLIENTS];
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+static bool bench_deliver(message_t *message)
+{
+    message_release(message);
+
+    return true;
+}
+
+static uint64_t bench_wake(uint64_t next_poll)
+{
+    uint64_t wake = (g_next_sweep_us < next_poll) ? g_next_sweep_us : next_poll;
+
+    for (int i = 0; i < BENCH_CLIENTS; i++)
+    {
+        bench_client_t *client = &g_clients[i];
+
+        if (client->state == BENCH_CONNECTING && client->next_attempt_us < wake)
+        {
+            wake = client->next_attempt_us;
+        }
+        else if (client->state == BENCH_CONNECTED && client->next_heartbeat_us < wake)
+        {
+            wake = client->next_heartbeat_us;
+        }
+    }
+
+    return wake;
+}
+
+/* From the first SYN of a client, the server only sees the connect that found a listener */
+static void bench_latency(bench_result_t *result, uint64_t latency)
+{
+    result->latency_sum_us += latency;
+    if (latency > result->latency_max_us)
+    {
+        result->latency_max_us = latency;
+    }
+}
+
+/* Connect attempts and heartbeats that are due */
+static void bench_clients(bench_result_t *result)
+{
+    for (int i = 0; i < BENCH_CLIENTS; i++)
+    {
+        bench_client_t *client = &g_clients[i];
+
+        if (client->state == BENCH_CONNECTING && g_now_us >= client->next_attempt_us)
+        {
+            client->socket = w5500_sim_accept(LISTENING_PORT);
+
+            if (client->socket < 0)
+            {
+                result->refused++;
+                client->next_attempt_us += BENCH_RETRY_US;
+                continue;
+            }
+
+            client->state = BENCH_CONNECTED;
+            client->next_heartbeat_us = g_now_us + KEEP_ALIVE_SECONDS * 1000 * 1000;
+            result->admitted++;
+            bench_latency(result, g_now_us - client->first_attempt_us);
+        }
+        else if (client->state == BENCH_CONNECTED && g_now_us >= client->next_heartbeat_us)
+        {
+            w5500_sim_receive(client->socket, (const uint8_t *)"HB#", 3);
+            client->next_heartbeat_us += KEEP_ALIVE_SECONDS * 1000 * 1000;
+        }
+    }
+}
+
+/* Clients whose socket the server closed, and the replies of the others */
+static void bench_check(bench_result_t *result)
+{
+    uint32_t concurrent = 0;
+    uint8_t buf[256];
+
+    for (int i = 0; i < BENCH_CLIENTS; i++)
+    {
+        bench_client_t *client = &g_clients[i];
+
+        if (client->state != BENCH_CONNECTED)
+        {
+            continue;
+        }
+
+        if (getSn_SR(client->socket) != SOCK_ESTABLISHED)
+        {
+            client->state = BENCH_EVICTED;
+            result->evicted++;
+            continue;
+        }
+
+        while (w5500_sim_take_sent(client->socket, buf, sizeof(buf)) > 0);
+        concurrent++;
+    }
+
+    if (concurrent > result->max_concurrent)
+    {
+        result->max_concurrent = concurrent;
+    }
+}
+
+/* All clients start connecting within a few ms, refused ones retry like a TCP stack does */
+static bench_result_t bench_storm(void)
+{
+    bench_result_t result = {0};
+    message_t none = {.message_type = NO_MESSAGE};
+    uint8_t ip[4] = {192, 168, 11, 2};
+    uint64_t end_us = (uint64_t)BENCH_SECONDS * 1000 * 1000;
+    uint64_t next_poll = 0;
+
+    message_pool_initialize();
+    w5500_sim_initialize();
+    setSIPR(ip);
+    g_now_us = 0;
+    firmware_sim_set_clock(&g_now_us);
+    g_next_sweep_us = BENCH_SWEEP_US;
+
+    for (int i = 0; i < BENCH_CLIENTS; i++)
+    {
+        g_clients[i].state = BENCH_CONNECTING;
+        g_clients[i].socket = -1;
+        g_clients[i].first_attempt_us = (uint64_t)(i + 1) * BENCH_ARRIVAL_US;
+        g_clients[i].next_attempt_us = g_clients[i].first_attempt_us;
+    }
+
+    server_start(NULL);
+
+    clock_t start = clock();
+
+    while (g_now_us < end_us)
+    {
+        uint64_t wake = bench_wake(next_poll);
+
+        if (wake > g_now_us)
+        {
+            g_now_us = wake;
+        }
+
+        bench_clients(&result);
+
+        bool sweep = g_now_us >= g_next_sweep_us;
+        if (sweep)
+        {
+            g_next_sweep_us = g_now_us + BENCH_SWEEP_US;
+        }
+
+        // Only the SPI traffic of the server counts, not the status reads of the benchmark
+        w5500_sim_reset_counters();
+        next_poll = server_poll(&none, sweep, bench_deliver);
+        result.transactions += w5500_sim_get_transaction_count();
+        result.polls++;
+
+        bench_check(&result);
+    }
+
+    result.seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    for (int i = 0; i < BENCH_CLIENTS; i++)
+    {
+        if (g_clients[i].state == BENCH_CONNECTING)
+        {
+            result.starved++;
+            bench_latency(&result, end_us - g_clients[i].first_attempt_us);
+        }
+    }
+
+    server_stop();
+
+    return result;
+}
+
+int main(void)
+{
+    bench_result_t result;
+
+    printf("Connect storm on a simulated W5500, %d listeners, %s\n", LISTENING_SOCKET_COUNT, BENCH_POLICY);
+    printf("%d clients %d ms apart, refused clients retry every %d ms, heartbeat every %d s, %d s\n",
+           BENCH_CLIENTS, BENCH_ARRIVAL_US / 1000, BENCH_RETRY_US / 1000, KEEP_ALIVE_SECONDS, BENCH_SECONDS);
+
+    result = bench_storm();
+
+    printf(" admitted %ld of %d clients, %ld never admitted, %ld connects refused, %ld evicted, %ld concurrent at most\n",
+           (long)result.admitted, BENCH_CLIENTS, (long)result.starved, (long)result.refused, (long)result.evicted,
+           (long)result.max_concurrent);
+    printf(" accept latency from the first SYN of every client, the run length for one never admitted: %.1f ms mean, %.1f ms max\n",
+           (double)result.latency_sum_us / BENCH_CLIENTS / 1000, (double)result.latency_max_us / 1000);
+    printf(" %ld polls, %.1f SPI transactions/poll, %.0f ns/poll on the host\n",
+           (long)result.polls, (double)result.transactions / result.polls, (result.seconds * 1e9) / result.polls);
+
+    return 0;
+}
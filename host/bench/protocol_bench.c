@@ -0,0 +1,177 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "protocol.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Benchmark */
+#define BENCH_MESSAGES 4000000
+#define BENCH_BATCH 8
+#define BENCH_TYPE_SET_SPEED 3         // MSG_SET_SPEED
+#define BENCH_TYPE_CURRENT_SPEED 2     // MSG_CURRENT_SPEEED
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+typedef struct bench_result_t
+{
+    double encode_ns;
+    double decode_ns;
+    double bytes;
+} bench_result_t;
+
+static volatile int32_t g_sink;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+static double bench_ns(clock_t start, uint32_t messages)
+{
+    return ((double)(clock() - start) / CLOCKS_PER_SEC) * 1e9 / messages;
+}
+
+/* The text protocol: replies with sprintf, requests with memchr and a strcmp per command */
+static int32_t bench_text_parse(char *buf, uint16_t len)
+{
+    char *end = memchr(buf, '#', len);
+
+    if (!end)
+    {
+        return -1;
+    }
+
+    *end = 0;
+
+    if (!strcmp(buf, "GET")) return 0;
+    if (!strcmp(buf, "SET0")) return 0;
+    if (!strcmp(buf, "SET1")) return 1;
+    if (!strcmp(buf, "SET2")) return 2;
+    if (!strcmp(buf, "SET3")) return 3;
+    if (!strcmp(buf, "HB")) return 0;
+    if (!strcmp(buf, "SPI")) return 0;
+
+    return -1;
+}
+
+static bench_result_t bench_text(void)
+{
+    bench_result_t result = {0};
+    char buf[16];
+    uint64_t bytes = 0;
+
+    clock_t start = clock();
+    for (uint32_t n = 0; n < BENCH_MESSAGES; n++)
+    {
+        bytes += sprintf(buf, "S%d#", (int)(n & 3));
+        g_sink += buf[1];
+    }
+    result.encode_ns = bench_ns(start, BENCH_MESSAGES);
+    result.bytes = (double)bytes / BENCH_MESSAGES;
+
+    start = clock();
+    for (uint32_t n = 0; n < BENCH_MESSAGES; n++)
+    {
+        memcpy(buf, "SET1#", 5);
+        buf[3] = '0' + (n & 3);
+        g_sink += bench_text_parse(buf, 5);
+    }
+    result.decode_ns = bench_ns(start, BENCH_MESSAGES);
+
+    return result;
+}
+
+/* Binary frames with count items each, the cost is per item */
+static bench_result_t bench_binary(uint8_t count)
+{
+    bench_result_t result = {0};
+    protocol_item_t items[PROTOCOL_MAX_ITEMS];
+    uint8_t frame[PROTOCOL_MAX_FRAME];
+    uint32_t frames = BENCH_MESSAGES / count;
+    uint64_t bytes = 0;
+    uint16_t size = 0;
+
+    clock_t start = clock();
+    for (uint32_t n = 0; n < frames; n++)
+    {
+        for (uint8_t i = 0; i < count; i++)
+        {
+            items[i].type = BENCH_TYPE_CURRENT_SPEED;
+            items[i].value = (int32_t)(n * count + i);
+        }
+        size = protocol_encode(frame, sizeof(frame), items, count);
+        bytes += size;
+        g_sink += frame[size - 1];
+    }
+    result.encode_ns = bench_ns(start, frames * count);
+    result.bytes = (double)bytes / (frames * count);
+
+    start = clock();
+    for (uint32_t n = 0; n < frames; n++)
+    {
+        uint8_t decoded = 0;
+
+        g_sink += protocol_decode(frame, size, items, &decoded);
+        for (uint8_t i = 0; i < decoded; i++)
+        {
+            g_sink += items[i].value;
+        }
+    }
+    result.decode_ns = bench_ns(start, frames * count);
+
+    return result;
+}
+
+static void bench_print(const char *name, bench_result_t result)
+{
+    printf(" %-14s: encode %5.1f ns/message, decode %5.1f ns/message, %4.1f bytes/message\n",
+           name, result.encode_ns, result.decode_ns, result.bytes);
+}
+
+int main(void)
+{
+    protocol_item_t items[PROTOCOL_MAX_ITEMS];
+    uint8_t frame[PROTOCOL_MAX_FRAME];
+    uint8_t decoded = 0;
+
+    // Round trip of the extreme 32 bit values before timing anything
+    items[0].type = BENCH_TYPE_SET_SPEED;
+    items[0].value = INT32_MIN;
+    items[1].type = BENCH_TYPE_SET_SPEED;
+    items[1].value = INT32_MAX;
+    uint16_t size = protocol_encode(frame, sizeof(frame), items, 2);
+    if (protocol_decode(frame, size, items, &decoded) != size || decoded != 2 ||
+        items[0].value != INT32_MIN || items[1].value != INT32_MAX)
+    {
+        printf("Binary round trip failed\n");
+        return 1;
+    }
+
+    printf("Protocol benchmark, %d messages, cost per message on the host\n", BENCH_MESSAGES);
+
+    bench_print("text", bench_text());
+    bench_print("binary", bench_binary(1));
+    bench_print("binary batch 8", bench_binary(BENCH_BATCH));
+
+    return 0;
+}
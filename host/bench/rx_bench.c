@@ -0,0 +1,238 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "wizchip_conf.h"
+#include "socket.h"
+#include "w5x00_socket.h"
+#include "w5500_sim.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Benchmark */
+#define BENCH_SOCKET 0
+#define BENCH_PORT 5000
+#define BENCH_BUFFER_SIZE 128          // BUFFER_SIZE of the server
+#define BENCH_COMMANDS 200000
+#define BENCH_SEGMENT_MAX 64           // Largest TCP segment of the peer
+#define BENCH_SPI_CLOCK_HZ 33000000    // SPI clock for the bus time estimate
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+typedef struct bench_result_t
+{
+    uint32_t commands;
+    uint64_t payload_bytes;
+    uint32_t transactions;
+    uint32_t spi_bytes;
+    double seconds;
+} bench_result_t;
+
+typedef uint32_t (*bench_pass_t)(uint8_t *buf, uint16_t size);
+
+static const char *g_commands[] = {"GET#", "SET0#", "SET1#", "SET2#", "SET3#", "HB#"};
+static uint32_t g_seed;
+static uint8_t g_buf[BENCH_BUFFER_SIZE];
+static uint16_t g_window_size;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+static uint32_t bench_random(void)
+{
+    g_seed = g_seed * 1103515245 + 12345;
+
+    return g_seed >> 16;
+}
+
+static bool bench_is_command(const char *command)
+{
+    return !strcmp(command, "GET") || !strcmp(command, "SET0") || !strcmp(command, "SET1") ||
+           !strcmp(command, "SET2") || !strcmp(command, "SET3") || !strcmp(command, "HB");
+}
+
+/* Before: copy into a cleared buffer, one command per read, the rest of the buffer is dropped */
+static uint32_t bench_pass_copy(uint8_t *buf, uint16_t size)
+{
+    wizchip_socket_snapshot_t snapshot;
+    uint16_t len;
+
+    wizchip_socket_snapshot(BENCH_SOCKET, &snapshot);
+
+    if ((len = snapshot.rx_received_size) == 0)
+    {
+        return 0;
+    }
+
+    if (len > size - 1)
+    {
+        len = size - 1;
+    }
+
+    memset(buf, 0, size);
+    wizchip_socket_recv(BENCH_SOCKET, &snapshot, buf, len);
+
+    char *end = strstr((char *)buf, "#");
+    if (end)
+    {
+        *end = 0;
+
+        return bench_is_command((char *)buf) ? 1 : 0;
+    }
+
+    return 0;
+}
+
+/* After: parse a window on the RX buffer, release only complete commands, keep the rest in the window */
+static uint32_t bench_pass_peek(uint8_t *buf, uint16_t size)
+{
+    wizchip_socket_snapshot_t snapshot;
+    uint32_t commands = 0;
+    uint16_t consumed = 0;
+
+    wizchip_socket_snapshot(BENCH_SOCKET, &snapshot);
+
+    if (snapshot.rx_received_size > g_window_size)
+    {
+        g_window_size += wizchip_socket_peek(BENCH_SOCKET, &snapshot, g_window_size, buf + g_window_size, size - g_window_size);
+    }
+
+    while (consumed < g_window_size)
+    {
+        char *start = (char *)buf + consumed;
+        char *end = memchr(start, '#', g_window_size - consumed);
+
+        if (!end)
+        {
+            if (consumed == 0 && g_window_size == size)
+            {
+                consumed = g_window_size;
+            }
+            break;
+        }
+
+        *end = 0;
+        consumed = (uint8_t *)end - buf + 1;
+        commands += bench_is_command(start) ? 1 : 0;
+    }
+
+    if (consumed > 0)
+    {
+        wizchip_socket_consume(BENCH_SOCKET, &snapshot, consumed);
+
+        g_window_size -= consumed;
+        memmove(buf, buf + consumed, g_window_size);
+    }
+
+    return commands;
+}
+
+static void bench_connect(void)
+{
+    uint8_t ip[4] = {192, 168, 11, 2};
+
+    w5500_sim_initialize();
+    setSIPR(ip);
+    g_window_size = 0;
+
+    socket(BENCH_SOCKET, Sn_MR_TCP, BENCH_PORT, 0x0);
+    listen(BENCH_SOCKET);
+    w5500_sim_connect(BENCH_SOCKET);
+    setSn_IR(BENCH_SOCKET, Sn_IR_CON);
+}
+
+static bench_result_t bench_run(bench_pass_t pass, uint16_t size)
+{
+    bench_result_t result = {0};
+    uint8_t stream[BENCH_SEGMENT_MAX * 2];
+    uint16_t stream_len = 0;
+    uint32_t sent = 0;
+
+    bench_connect();
+    w5500_sim_reset_counters();
+    g_seed = 1;
+
+    clock_t start = clock();
+
+    while (sent < BENCH_COMMANDS || stream_len > 0)
+    {
+        // Next segment of the peer, commands are split at random points
+        while (sent < BENCH_COMMANDS && stream_len < BENCH_SEGMENT_MAX)
+        {
+            const char *command = g_commands[bench_random() % (sizeof(g_commands) / sizeof(g_commands[0]))];
+
+            memcpy(stream + stream_len, command, strlen(command));
+            stream_len += strlen(command);
+            sent++;
+        }
+
+        uint16_t segment = 1 + bench_random() % BENCH_SEGMENT_MAX;
+        if (segment > stream_len)
+        {
+            segment = stream_len;
+        }
+
+        segment = w5500_sim_receive(BENCH_SOCKET, stream, segment);
+        memmove(stream, stream + segment, stream_len - segment);
+        stream_len -= segment;
+        result.payload_bytes += segment;
+
+        // One server pass per RECV interrupt
+        while (getSn_IR(BENCH_SOCKET) & Sn_IR_RECV)
+        {
+            setSn_IR(BENCH_SOCKET, Sn_IR_RECV);
+            result.commands += pass(g_buf, size);
+        }
+    }
+
+    result.seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    result.transactions = w5500_sim_get_transaction_count();
+    result.spi_bytes = w5500_sim_get_byte_count();
+
+    return result;
+}
+
+static void bench_print(const char *name, bench_result_t result)
+{
+    uint32_t commands = result.commands ? result.commands : 1;
+    double bus_seconds = ((double)result.spi_bytes * 8) / BENCH_SPI_CLOCK_HZ;
+
+    printf(" %-4s: %6ld/%d commands parsed, %5.2f transactions/command, %6.1f SPI bytes/command, "
+           "%7.0f commands/s on a %d MHz bus, %4.0f ns/command on the host\n",
+           name, (long)result.commands, BENCH_COMMANDS,
+           (double)result.transactions / commands,
+           (double)result.spi_bytes / commands,
+           result.commands / bus_seconds, BENCH_SPI_CLOCK_HZ / 1000000,
+           (result.seconds * 1e9) / commands);
+}
+
+int main(void)
+{
+    printf("RX path benchmark on a simulated W5500, %d commands in segments of 1 to %d bytes\n",
+           BENCH_COMMANDS, BENCH_SEGMENT_MAX);
+
+    bench_print("copy", bench_run(bench_pass_copy, BENCH_BUFFER_SIZE));
+    bench_print("peek", bench_run(bench_pass_peek, BENCH_BUFFER_SIZE));
+
+    return 0;
+}
@@ -0,0 +1,302 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "wizchip_conf.h"
+#include "socket.h"
+#include "w5x00_spi.h"
+#include "w5500_sim.h"
+#include "firmware_sim.h"
+#include "server.h"
+#include "socket_memory.h"
+#include "message_pool.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Benchmark */
+#define BENCH_IDLE_SECONDS 600         // simulated time without commands
+#define BENCH_COMMANDS 100000
+#define BENCH_SPI_CLOCK_HZ 33000000    // SPI clock for the bus time estimate
+#define BENCH_SWEEP_US ((uint64_t)SERVER_SWEEP_TICKS * 1000)
+#define BENCH_CLIENTS (LISTENING_SOCKET_COUNT - SERVER_POOL_SPARE)  // the most clients that are never evicted
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+typedef struct bench_result_t
+{
+    uint32_t polls;
+    uint32_t transactions;
+    uint32_t spi_bytes;
+    uint32_t delivered;                // commands that went to the control tasks
+    uint32_t unanswered;
+    double seconds;
+} bench_result_t;
+
+static uint64_t g_now_us;
+static uint64_t g_next_sweep_us;
+static uint32_t g_delivered;
+static message_t g_last_delivered;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Socket of the i-th listener of the pool, the DHCP socket is not in it */
+static uint8_t bench_socket(int i)
+{
+    return (i < SOCKET_MEMORY_DHCP_SOCKET) ? i : i + 1;
+}
+
+static bool bench_deliver(message_t *message)
+{
+    g_delivered++;
+    g_last_delivered = *message;
+    message_release(message);
+
+    return true;
+}
+
+/* One pass of the server_task loop */
+static uint64_t bench_poll(message_t *send_message)
+{
+    bool sweep = g_now_us >= g_next_sweep_us;
+
+    if (sweep)
+    {
+        g_next_sweep_us = g_now_us + BENCH_SWEEP_US;
+    }
+
+    return server_poll(send_message, sweep, bench_deliver);
+}
+
+static void bench_start(int connections)
+{
+    uint8_t ip[4] = {192, 168, 11, 2};
+    message_t none = {.message_type = NO_MESSAGE};
+
+    message_pool_initialize();
+    w5500_sim_initialize();
+    setSIPR(ip);
+    g_now_us = 0;
+    firmware_sim_set_clock(&g_now_us);
+    g_next_sweep_us = BENCH_SWEEP_US;
+
+    server_start(NULL);
+
+    for (int i = 0; i < connections; i++)
+    {
+        w5500_sim_connect(bench_socket(i));
+    }
+
+    bench_poll(&none);
+}
+
+static void bench_stop(void)
+{
+    server_stop();
+
+    for (int i = 0; i < LISTENING_SOCKET_COUNT; i++)
+    {
+        close(bench_socket(i));
+    }
+}
+
+static void bench_drain(int connections)
+{
+    uint8_t buf[256];
+
+    for (int i = 0; i < connections; i++)
+    {
+        while (w5500_sim_take_sent(bench_socket(i), buf, sizeof(buf)) > 0);
+    }
+}
+
+/* Connected clients that only send their heartbeat, the server sleeps until the next deadline.
+ * Without clients nothing but a W5x00 interrupt wakes it up. */
+static bench_result_t bench_idle(int connections)
+{
+    bench_result_t result = {0};
+    message_t none = {.message_type = NO_MESSAGE};
+    uint64_t end_us = (uint64_t)BENCH_IDLE_SECONDS * 1000 * 1000;
+    uint64_t next_heartbeat_us = KEEP_ALIVE_SECONDS * 1000 * 1000;
+    uint64_t next_poll = 0;
+
+    bench_start(connections);
+    w5500_sim_reset_counters();
+
+    clock_t start = clock();
+
+    while (g_now_us < end_us)
+    {
+        uint64_t wake = next_poll;
+
+        if (connections > 0 && next_heartbeat_us < wake)
+        {
+            wake = next_heartbeat_us;
+        }
+        // server_task only wakes up for a sweep while a memory profile waits to be applied
+        if (server_sweep_pending() && g_next_sweep_us < wake)
+        {
+            wake = g_next_sweep_us;
+        }
+        // No deadline at all, the server sleeps until a W5x00 interrupt
+        if (wake == UINT64_MAX)
+        {
+            break;
+        }
+        if (wake > g_now_us)
+        {
+            g_now_us = wake;
+        }
+
+        // The clients send HB# on their own keep alive period, the W5x00 interrupt wakes the server
+        if (g_now_us >= next_heartbeat_us)
+        {
+            for (int i = 0; i < connections; i++)
+            {
+                w5500_sim_receive(bench_socket(i), (const uint8_t *)"HB#", 3);
+            }
+            next_heartbeat_us += KEEP_ALIVE_SECONDS * 1000 * 1000;
+        }
+
+        next_poll = bench_poll(&none);
+        result.polls++;
+        bench_drain(connections);
+    }
+
+    result.seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    result.transactions = w5500_sim_get_transaction_count();
+    result.spi_bytes = w5500_sim_get_byte_count();
+
+    bench_stop();
+
+    return result;
+}
+
+/* A command on one of the connections, the poll that delivers it and the poll that sends the reply.
+ * A status request answered from the state snapshot of ventcontrol_task leaves in the first poll. */
+static bench_result_t bench_latency(int connections, const char *command)
+{
+    bench_result_t result = {0};
+    message_t none = {.message_type = NO_MESSAGE};
+    uint8_t reply[16];
+
+    bench_start(connections);
+    w5500_sim_reset_counters();
+    g_delivered = 0;
+
+    clock_t start = clock();
+
+    for (uint32_t n = 0; n < BENCH_COMMANDS; n++)
+    {
+        uint8_t sn = bench_socket(n % connections);
+        message_t send_message;
+
+        // 1 ms between commands keeps the heartbeats of the other connections on their deadlines
+        g_now_us += 1000;
+
+        uint32_t delivered = g_delivered;
+
+        w5500_sim_receive(sn, (const uint8_t *)command, strlen(command));
+        bench_poll(&none);
+        result.polls++;
+
+        // The reply carries the hops of the command like ventcontrol_task does
+        if (g_delivered != delivered)
+        {
+            send_message = g_last_delivered;
+            send_message.message_type = MSG_CURRENT_SPEEED;
+            send_message.value = 1;
+            bench_poll(&send_message);
+            result.polls++;
+        }
+
+        if (w5500_sim_take_sent(sn, reply, sizeof(reply)) == 0)
+        {
+            result.unanswered++;
+        }
+        bench_drain(connections);
+    }
+
+    result.seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    result.transactions = w5500_sim_get_transaction_count();
+    result.spi_bytes = w5500_sim_get_byte_count();
+
+    result.delivered = g_delivered;
+
+    bench_stop();
+
+    return result;
+}
+
+static void bench_print_idle(int connections, bench_result_t result)
+{
+    double bus_seconds = ((double)result.spi_bytes * 8) / BENCH_SPI_CLOCK_HZ;
+
+    printf(" idle, %d connection%s: %6.2f polls/s, %7.2f transactions/s, %8.1f SPI bytes/s, "
+           "bus busy %.4f%% at %d MHz\n",
+           connections, connections == 1 ? " " : "s",
+           (double)result.polls / BENCH_IDLE_SECONDS,
+           (double)result.transactions / BENCH_IDLE_SECONDS,
+           (double)result.spi_bytes / BENCH_IDLE_SECONDS,
+           (bus_seconds * 100) / BENCH_IDLE_SECONDS, BENCH_SPI_CLOCK_HZ / 1000000);
+}
+
+static void bench_print_latency(int connections, bench_result_t result)
+{
+    double bus_seconds = ((double)result.spi_bytes * 8) / BENCH_SPI_CLOCK_HZ;
+
+    printf(" command, %d connection%s: %4.2f polls/command, %3d%% queued, %5.2f transactions/command, "
+           "%6.1f SPI bytes/command, %5.1f us bus time/command at %d MHz, %4.0f ns/command on the host\n",
+           connections, connections == 1 ? " " : "s",
+           (double)result.polls / BENCH_COMMANDS, (int)(((uint64_t)result.delivered * 100) / BENCH_COMMANDS),
+           (double)result.transactions / BENCH_COMMANDS,
+           (double)result.spi_bytes / BENCH_COMMANDS,
+           (bus_seconds * 1e6) / BENCH_COMMANDS, BENCH_SPI_CLOCK_HZ / 1000000,
+           (result.seconds * 1e9) / BENCH_COMMANDS);
+
+    if (result.unanswered > 0)
+    {
+        printf("  %ld of %d commands without a reply\n", (long)result.unanswered, BENCH_COMMANDS);
+    }
+}
+
+int main(void)
+{
+    printf("Server scheduler benchmark on a simulated W5500, %d listeners\n", LISTENING_SOCKET_COUNT);
+
+    printf("%d s without commands, heartbeat every %d s\n", BENCH_IDLE_SECONDS, KEEP_ALIVE_SECONDS);
+    bench_print_idle(0, bench_idle(0));
+    bench_print_idle(1, bench_idle(1));
+    bench_print_idle(BENCH_CLIENTS, bench_idle(BENCH_CLIENTS));
+
+    printf("%d commands, SET1# to the server and S1# back\n", BENCH_COMMANDS);
+    bench_print_latency(1, bench_latency(1, "SET1#"));
+    bench_print_latency(BENCH_CLIENTS, bench_latency(BENCH_CLIENTS, "SET1#"));
+
+    // Through receive_queue and send_queue with SERVER_GET_QUEUED, like SET1#
+    printf("%d status requests, GET# to the server and S1# back\n", BENCH_COMMANDS);
+    bench_print_latency(1, bench_latency(1, "GET#"));
+    bench_print_latency(BENCH_CLIENTS, bench_latency(BENCH_CLIENTS, "GET#"));
+
+    return 0;
+}
@@ -0,0 +1,244 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "state_snapshot.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Benchmark */
+#define BENCH_REQUESTS 200000
+#define BENCH_QUEUE_LENGTH 10          // MAX_QUEUE_LENGTH of receive_queue and send_queue
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* A FreeRTOS queue of the firmware: items are copied in and out, a reader blocks until one arrives */
+typedef struct bench_queue_t
+{
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    int items[BENCH_QUEUE_LENGTH];
+    uint32_t head;
+    uint32_t tail;
+} bench_queue_t;
+
+typedef struct bench_result_t
+{
+    uint32_t latencies[BENCH_REQUESTS];    // ns per status request
+    uint32_t retries;
+    uint32_t torn;                         // reads that mixed two writes, always 0 for a working seqlock
+    uint32_t writes;
+    double seconds;
+} bench_result_t;
+
+static bench_queue_t g_receive_queue;
+static bench_queue_t g_send_queue;
+static state_snapshot_t g_snapshot;
+static volatile bool g_run;
+static bench_result_t g_result;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+static uint64_t bench_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void bench_queue_init(bench_queue_t *queue)
+{
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->ready, NULL);
+    queue->head = 0;
+    queue->tail = 0;
+}
+
+static void bench_queue_send(bench_queue_t *queue, int item)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->items[queue->head++ % BENCH_QUEUE_LENGTH] = item;
+    pthread_cond_signal(&queue->ready);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static int bench_queue_receive(bench_queue_t *queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->head == queue->tail)
+    {
+        pthread_cond_wait(&queue->ready, &queue->lock);
+    }
+    int item = queue->items[queue->tail++ % BENCH_QUEUE_LENGTH];
+    pthread_mutex_unlock(&queue->lock);
+
+    return item;
+}
+
+/* ventcontrol_task before: every status request is answered with the current speed, -1 stops it */
+static void *bench_control(void *argument)
+{
+    int speed = 1;
+
+    while (bench_queue_receive(&g_receive_queue) >= 0)
+    {
+        bench_queue_send(&g_send_queue, speed);
+    }
+
+    return NULL;
+}
+
+/* ventcontrol_task after: changes the state as fast as it can, speed is always the low bits of program_ends_at */
+static void *bench_writer(void *argument)
+{
+    uint64_t n = 0;
+
+    while (g_run)
+    {
+        vent_state_t state = {(int)(n & 3), n};
+
+        state_snapshot_write(&g_snapshot, &state);
+        n++;
+    }
+
+    g_result.writes = n;
+
+    return NULL;
+}
+
+/* GET# through receive_queue to ventcontrol_task and S<speed># back through send_queue */
+static void bench_queued(void)
+{
+    pthread_t control;
+
+    bench_queue_init(&g_receive_queue);
+    bench_queue_init(&g_send_queue);
+    pthread_create(&control, NULL, bench_control, NULL);
+
+    uint64_t start = bench_ns();
+
+    for (uint32_t n = 0; n < BENCH_REQUESTS; n++)
+    {
+        uint64_t sent = bench_ns();
+
+        bench_queue_send(&g_receive_queue, 0);
+        bench_queue_receive(&g_send_queue);
+        g_result.latencies[n] = bench_ns() - sent;
+    }
+
+    g_result.seconds = (double)(bench_ns() - start) / 1e9;
+
+    bench_queue_send(&g_receive_queue, -1);
+    pthread_join(control, NULL);
+}
+
+/* GET# answered by the server from the snapshot, while ventcontrol_task writes it without a pause.
+ * A host thread can be preempted in the middle of a write, the reader spins until it runs again: the max.
+ * ventcontrol_task suspends the scheduler for the write. */
+static void bench_snapshot(bool contended)
+{
+    pthread_t writer;
+    vent_state_t initial = {0, 0};
+
+    g_snapshot.sequence = 0;
+    state_snapshot_write(&g_snapshot, &initial);
+    g_result.writes = 0;
+    g_run = true;
+
+    if (contended)
+    {
+        pthread_create(&writer, NULL, bench_writer, NULL);
+    }
+
+    uint64_t start = bench_ns();
+
+    for (uint32_t n = 0; n < BENCH_REQUESTS; n++)
+    {
+        vent_state_t state;
+        uint64_t sent = bench_ns();
+
+        g_result.retries += state_snapshot_read(&g_snapshot, &state);
+        g_result.latencies[n] = bench_ns() - sent;
+
+        if (contended && (uint64_t)state.speed != (state.program_ends_at & 3))
+        {
+            g_result.torn++;
+        }
+    }
+
+    g_result.seconds = (double)(bench_ns() - start) / 1e9;
+    g_run = false;
+
+    if (contended)
+    {
+        pthread_join(writer, NULL);
+    }
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void bench_print(const char *name)
+{
+    qsort(g_result.latencies, BENCH_REQUESTS, sizeof(uint32_t), bench_compare);
+
+    printf(" %-34s %10.0f requests/s, p50 %6ld ns, p99 %6ld ns, max %8ld ns",
+           name, BENCH_REQUESTS / g_result.seconds,
+           (long)g_result.latencies[BENCH_REQUESTS / 2], (long)g_result.latencies[(BENCH_REQUESTS * 99) / 100],
+           (long)g_result.latencies[BENCH_REQUESTS - 1]);
+
+    if (g_result.writes > 0)
+    {
+        printf(", %ld writes, %ld retries, %ld torn", (long)g_result.writes, (long)g_result.retries, (long)g_result.torn);
+    }
+    printf("\n");
+
+    memset(&g_result, 0, sizeof(g_result));
+}
+
+int main(void)
+{
+    printf("Status requests, %d each, one host thread per task. The firmware pays a task switch where the host\n"
+           "wakes a thread, the host numbers compare the two paths but are not the times of the RP2040.\n", BENCH_REQUESTS);
+
+    bench_queued();
+    bench_print("receive_queue and send_queue:");
+
+    bench_snapshot(false);
+    bench_print("state snapshot:");
+
+    bench_snapshot(true);
+    bench_print("state snapshot, writer never idle:");
+
+    return 0;
+}
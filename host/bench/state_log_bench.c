@@ -0,0 +1,265 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "flash_sim.h"
+#include "state_log.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Benchmark */
+#define BENCH_WEAR_DAYS 30
+#define BENCH_CHANGE_US (1000 * 1000)          // a client that changes the speed every second, all day
+#define BENCH_ERASE_CYCLES 100000              // endurance of a sector of the QSPI flash
+#define BENCH_CUT_RECORDS (STATE_LOG_SLOTS * 2 + STATE_LOG_SECTOR_SLOTS)  // past a wrap of the region
+#define BENCH_CUT_AFTER 3                      // records written after the restore, the log has to go on
+#define BENCH_RESTORES 1000
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+static uint64_t g_now_us;
+
+/* Bytes of the interrupted erase or program that reach the flash */
+static const uint32_t g_cut_bytes[] = {0, 1, 2, 8, 63, 64, 200, 2048};
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Simulated firmware */
+uint64_t time_us_64(void)
+{
+    return g_now_us;
+}
+
+/* Every record carries its number in push_seconds, the speed follows it */
+static void bench_state(uint32_t tag, int *speed, program_state_t *program)
+{
+    memset(program, 0, sizeof(program_state_t));
+    program->ends_at = UINT64_MAX;
+    program->revert_speed = PROGRAM_NO_SPEED;
+    program->push_seconds = tag;
+    *speed = tag % (PROGRAM_MAX_SPEED + 1);
+}
+
+/* One record, the interval since the last one has passed */
+static void bench_write(uint32_t tag)
+{
+    program_state_t program;
+    int speed;
+
+    bench_state(tag, &speed, &program);
+    g_now_us += STATE_LOG_INTERVAL_US;
+    state_log_update(speed, &program, g_now_us);
+}
+
+/* The tag of the restored record, 0 on a blank region */
+static uint32_t bench_restore(void)
+{
+    program_state_t program;
+    int speed;
+
+    if (!state_log_restore(&speed, &program, g_now_us))
+    {
+        return 0;
+    }
+
+    if (speed != (int)(program.push_seconds % (PROGRAM_MAX_SPEED + 1)))
+    {
+        return UINT32_MAX;
+    }
+
+    return program.push_seconds;
+}
+
+/* A speed change every BENCH_CHANGE_US, merged into one record per STATE_LOG_INTERVAL_US */
+static void bench_wear(void)
+{
+    flash_sim_stats_t stats;
+    state_log_stats_t log_stats;
+    uint64_t end_us = (uint64_t)BENCH_WEAR_DAYS * 24 * 60 * 60 * 1000 * 1000;
+    uint32_t changes = 0;
+
+    flash_sim_initialize();
+    g_now_us = 0;
+    bench_restore();
+
+    while (g_now_us < end_us)
+    {
+        program_state_t program;
+        int speed;
+
+        g_now_us += BENCH_CHANGE_US;
+        bench_state(++changes, &speed, &program);
+        state_log_update(speed, &program, g_now_us);
+    }
+
+    flash_sim_get_stats(&stats);
+    state_log_get_stats(&log_stats);
+
+    uint32_t least = stats.erases[0];
+    uint32_t most = stats.erases[0];
+
+    for (int i = 1; i < FLASH_REGION_SECTORS; i++)
+    {
+        least = (stats.erases[i] < least) ? stats.erases[i] : least;
+        most = (stats.erases[i] > most) ? stats.erases[i] : most;
+    }
+
+    double erases_per_day = (double)most / BENCH_WEAR_DAYS;
+
+    printf("%d days, a speed change every %d ms:\n", BENCH_WEAR_DAYS, BENCH_CHANGE_US / 1000);
+    printf(" %lu changes, %lu records, %lu merged, %lu page programs, %lu flash errors\n",
+           (unsigned long)changes, (unsigned long)log_stats.records, (unsigned long)log_stats.merged,
+           (unsigned long)stats.programs, (unsigned long)stats.errors);
+    printf(" erases per sector %lu to %lu, %.1f per day, %d cycles last %.1f years\n",
+           (unsigned long)least, (unsigned long)most, erases_per_day, BENCH_ERASE_CYCLES,
+           BENCH_ERASE_CYCLES / erases_per_day / 365);
+}
+
+/* A power cut in every erase and program of a log that wraps the region twice, with every cut size.
+ * The restore has to find the record before the interrupted one, or the interrupted one once its
+ * magic is complete, and the log has to go on from there. */
+static void bench_power_cut(void)
+{
+    uint32_t trials = 0;
+    uint32_t newer = 0;
+    uint32_t failures = 0;
+    uint32_t operations = 0;
+    state_log_stats_t log_stats;
+
+    // Erases and programs of the whole run, every one of them gets cut
+    flash_sim_initialize();
+    g_now_us = 0;
+    bench_restore();
+    for (uint32_t tag = 1; tag <= BENCH_CUT_RECORDS; tag++)
+    {
+        bench_write(tag);
+    }
+
+    flash_sim_stats_t stats;
+    flash_sim_get_stats(&stats);
+    operations = stats.programs;
+    for (int i = 0; i < FLASH_REGION_SECTORS; i++)
+    {
+        operations += stats.erases[i];
+    }
+
+    for (uint32_t cut = 0; cut < operations; cut++)
+    {
+        for (uint32_t b = 0; b < sizeof(g_cut_bytes) / sizeof(g_cut_bytes[0]); b++)
+        {
+            uint32_t tag = 0;
+
+            flash_sim_initialize();
+            g_now_us = 0;
+            bench_restore();
+            flash_sim_cut_power(cut, g_cut_bytes[b]);
+
+            while (!flash_sim_power_cut())
+            {
+                bench_write(++tag);
+            }
+
+            flash_sim_power_on();
+            uint32_t restored = bench_restore();
+
+            trials++;
+            newer += (restored == tag) ? 1 : 0;
+
+            if (restored != tag && restored != tag - 1)
+            {
+                failures++;
+                printf(" cut in operation %lu after %lu bytes: record %lu restored, %lu was written\n",
+                       (unsigned long)cut, (unsigned long)g_cut_bytes[b], (unsigned long)restored, (unsigned long)tag);
+                continue;
+            }
+
+            for (uint32_t n = 1; n <= BENCH_CUT_AFTER; n++)
+            {
+                bench_write(tag + n);
+            }
+
+            if (bench_restore() != tag + BENCH_CUT_AFTER)
+            {
+                failures++;
+                printf(" cut in operation %lu after %lu bytes: the log did not go on\n",
+                       (unsigned long)cut, (unsigned long)g_cut_bytes[b]);
+            }
+        }
+    }
+
+    state_log_get_stats(&log_stats);
+
+    printf("Power cuts in each of %lu erases and programs, %d cut sizes:\n", (unsigned long)operations,
+           (int)(sizeof(g_cut_bytes) / sizeof(g_cut_bytes[0])));
+    printf(" %lu trials, %lu restored the interrupted record, %lu the one before, %lu slots skipped after a cut, "
+           "%lu failed\n", (unsigned long)trials, (unsigned long)newer, (unsigned long)(trials - newer - failures),
+           (unsigned long)log_stats.skipped, (unsigned long)failures);
+}
+
+/* The restore reads every slot once, a full region is the longest */
+static void bench_restore_time(void)
+{
+    flash_sim_stats_t before;
+    flash_sim_stats_t after;
+    state_log_stats_t log_stats;
+
+    flash_sim_initialize();
+    g_now_us = 0;
+    bench_restore();
+    for (uint32_t tag = 1; tag <= STATE_LOG_SLOTS + STATE_LOG_SLOTS / 2; tag++)
+    {
+        bench_write(tag);
+    }
+
+    flash_sim_get_stats(&before);
+    clock_t start = clock();
+
+    for (int i = 0; i < BENCH_RESTORES; i++)
+    {
+        bench_restore();
+    }
+
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    flash_sim_get_stats(&after);
+    state_log_get_stats(&log_stats);
+
+    printf("Restore of a full region, %d slots of %d bytes:\n", STATE_LOG_SLOTS, STATE_LOG_RECORD_SIZE);
+    printf(" %lu slots and %lu bytes read per restore, %.1f us on the host\n",
+           (unsigned long)log_stats.restore_slots,
+           (unsigned long)((after.read_bytes - before.read_bytes) / BENCH_RESTORES),
+           (seconds * 1e6) / BENCH_RESTORES);
+}
+
+int main(void)
+{
+    printf("State log on a simulated flash region, %d sectors of %d bytes, a record at most every %d s\n",
+           FLASH_REGION_SECTORS, FLASH_REGION_SECTOR_SIZE, STATE_LOG_INTERVAL_US / (1000 * 1000));
+
+    bench_wear();
+    bench_power_cut();
+    bench_restore_time();
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+#include "queue.h"
+
+#include "wizchip_conf.h"
+#include "w5x00_spi.h"
+#include "w5x00_gpio_irq.h"
+
+#include "server.h"
+#include "ventcontrol.h"
+#include "types.h"
+#include "latency.h"
+#include "message_pool.h"
+
+#include "w5500_sim.h"
+#include "w5500_posix.h"
+#include "firmware_sim.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Task, the priorities of the firmware */
+#define SERVER_TASK_STACK_SIZE 4096
+#define SERVER_TASK_PRIORITY 4
+
+#define NETWORK_TASK_STACK_SIZE 4096
+#define NETWORK_TASK_PRIORITY SERVER_TASK_PRIORITY
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Server data */
+static server_data_t server_data;
+
+static uint32_t g_seconds = 0;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Task */
+static void network_task(void *argument);
+
+/* FreeRTOS */
+void vAssertCalled(const char *file, unsigned long line)
+{
+    fprintf(stderr, "Assert in %s line %lu\n", file, line);
+    abort();
+}
+
+/* SPI transactions of the tasks and the host side do not interleave */
+static void posix_critical_section_lock(void)
+{
+    vTaskSuspendAll();
+}
+
+static void posix_critical_section_unlock(void)
+{
+    xTaskResumeAll();
+}
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Main
+ * ----------------------------------------------------------------------------------------------------
+ */
+int main(int argc, char **argv)
+{
+    uint8_t ip[4] = {127, 0, 0, 1};
+    uint16_t port = LISTENING_PORT;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-v"))
+        {
+            firmware_sim_set_log(true);
+        }
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+        {
+            port = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+        {
+            g_seconds = atoi(argv[++i]);
+        }
+        else
+        {
+            printf("usage: %s [-p port] [-t seconds] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    w5500_sim_initialize();
+    reg_wizchip_cris_cbfunc(posix_critical_section_lock, posix_critical_section_unlock);
+    w5500_posix_initialize();
+    w5500_posix_map_port(LISTENING_PORT, port);
+    setSIPR(ip);
+
+    // The address is static, the server starts right away
+    message_pool_initialize();
+    server_data.receive_queue = xQueueCreate(MAX_QUEUE_LENGTH, sizeof(message_t*));
+    server_data.send_queue = xQueueCreate(MAX_QUEUE_LENGTH, sizeof(message_t*));
+    server_data.ip_assigned_sem = xSemaphoreCreateCounting((unsigned portBASE_TYPE)0x7fffffff, (unsigned portBASE_TYPE)0);
+    server_data.server_run = true;
+    server_data.server_task = NULL;
+    xSemaphoreGive(server_data.ip_assigned_sem);
+
+    printf("server_task on the FreeRTOS POSIX port, simulated W5500, port %d, %d listeners\n", port, LISTENING_SOCKET_COUNT);
+
+    xTaskCreate(network_task, "Network_Task", NETWORK_TASK_STACK_SIZE, NULL, NETWORK_TASK_PRIORITY, NULL);
+    xTaskCreate(server_task, "Server_TASK", SERVER_TASK_STACK_SIZE, &server_data, SERVER_TASK_PRIORITY, NULL);
+    xTaskCreate(ventcontrol_task, "Ventcontrol_TASK", SERVER_TASK_STACK_SIZE, &server_data, SERVER_TASK_PRIORITY, NULL);
+
+    vTaskStartScheduler();
+
+    while (1)
+        ;
+}
+
+/* The INT pin: host sockets are moved every tick, a pending socket interrupt wakes up server_task
+ * like the GPIO interrupt of the firmware does */
+static void network_task(void *argument)
+{
+    uint64_t stop = g_seconds ? time_us_64() + (uint64_t)g_seconds * 1000000 : 0;
+    w5500_posix_stats_t stats;
+
+    while (1)
+    {
+        bool pending;
+
+        vTaskSuspendAll();
+        pending = w5500_posix_poll(0);
+        xTaskResumeAll();
+
+        if (pending)
+        {
+            firmware_sim_interrupt();
+        }
+
+        if (stop && time_us_64() >= stop)
+        {
+            break;
+        }
+
+        vTaskDelay(1);
+    }
+
+    w5500_posix_get_stats(&stats);
+    printf("Host clients: %lu accepted, %lu refused, %lu closed by the server, %lu left\n",
+           (unsigned long)stats.accepted, (unsigned long)stats.refused, (unsigned long)stats.closed,
+           (unsigned long)stats.disconnected);
+
+    firmware_sim_set_log(true);
+    latency_print_stats();
+    message_pool_print_stats();
+    ventcontrol_print_stats();
+    exit(0);
+}
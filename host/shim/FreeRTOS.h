@@ -0,0 +1,25 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _HOST_SHIM_FREERTOS_H_
+#define _HOST_SHIM_FREERTOS_H_
+
+/* The FreeRTOS types the server sources use. The host benchmarks call server_start and
+ * server_poll directly, the task functions are never run. */
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define portYIELD_FROM_ISR(x) (void)(x)
+
+#endif /* _HOST_SHIM_FREERTOS_H_ */
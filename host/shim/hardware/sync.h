@@ -0,0 +1,13 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _HOST_SHIM_HARDWARE_SYNC_H_
+#define _HOST_SHIM_HARDWARE_SYNC_H_
+
+/* The data memory barrier of the Cortex-M0+, a full barrier of the host compiler */
+static inline void __dmb(void) { __sync_synchronize(); }
+
+#endif /* _HOST_SHIM_HARDWARE_SYNC_H_ */
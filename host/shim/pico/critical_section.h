@@ -0,0 +1,20 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _HOST_SHIM_PICO_CRITICAL_SECTION_H_
+#define _HOST_SHIM_PICO_CRITICAL_SECTION_H_
+
+/* The host runs the server sources on one thread, or on one FreeRTOS task at a time */
+typedef struct critical_section
+{
+    int unused;
+} critical_section_t;
+
+static inline void critical_section_init(critical_section_t *crit_sec) { (void)crit_sec; }
+static inline void critical_section_enter_blocking(critical_section_t *crit_sec) { (void)crit_sec; }
+static inline void critical_section_exit(critical_section_t *crit_sec) { (void)crit_sec; }
+
+#endif /* _HOST_SHIM_PICO_CRITICAL_SECTION_H_ */
@@ -0,0 +1,20 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _HOST_SHIM_PICO_STDLIB_H_
+#define _HOST_SHIM_PICO_STDLIB_H_
+
+/* The pico-sdk functions the server sources use, time_us_64 is provided by the benchmark */
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef unsigned int uint;
+
+struct repeating_timer;
+
+uint64_t time_us_64(void);
+
+#endif /* _HOST_SHIM_PICO_STDLIB_H_ */
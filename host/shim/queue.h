@@ -0,0 +1,17 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _HOST_SHIM_QUEUE_H_
+#define _HOST_SHIM_QUEUE_H_
+
+#include "FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+static inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) { (void)queue; (void)item; (void)ticks; return pdFALSE; }
+static inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) { (void)queue; (void)item; (void)ticks; return pdFALSE; }
+
+#endif /* _HOST_SHIM_QUEUE_H_ */
@@ -0,0 +1,22 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _HOST_SHIM_TASK_H_
+#define _HOST_SHIM_TASK_H_
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+static inline TaskHandle_t xTaskGetCurrentTaskHandle(void) { return NULL; }
+static inline TickType_t xTaskGetTickCount(void) { return 0; }
+static inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) { (void)clear; (void)ticks; return 0; }
+static inline BaseType_t xTaskNotifyGive(TaskHandle_t task) { (void)task; return pdTRUE; }
+static inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) { (void)task; (void)woken; }
+static inline void vTaskSuspendAll(void) {}
+static inline BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+
+#endif /* _HOST_SHIM_TASK_H_ */
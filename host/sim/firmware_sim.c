@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "wizchip_conf.h"
+#include "w5x00_spi.h"
+#include "w5500_sim.h"
+#include "firmware_sim.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+static const uint64_t *g_now_us = NULL;
+static bool g_log = false;
+static void (*g_interrupt_callback)(void) = NULL;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+void firmware_sim_set_clock(const uint64_t *now_us)
+{
+    g_now_us = now_us;
+}
+
+void firmware_sim_set_log(bool enabled)
+{
+    g_log = enabled;
+}
+
+void firmware_sim_interrupt(void)
+{
+    if (g_interrupt_callback != NULL)
+    {
+        g_interrupt_callback();
+    }
+}
+
+/* The pico-sdk clock */
+uint64_t time_us_64(void)
+{
+    struct timespec now;
+
+    if (g_now_us != NULL)
+    {
+        return *g_now_us;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/* The INT pin of the port layer, the interrupt flags of the simulated W5500 */
+void wizchip_gpio_interrupt_initialize_mask(uint8_t socket_mask, void (*callback)(void))
+{
+    for (uint8_t sn = 0; sn < _WIZCHIP_SOCK_NUM_; sn++)
+    {
+        setSn_IMR(sn, (socket_mask & (1 << sn)) ? (Sn_IR_CON | Sn_IR_DISCON | Sn_IR_RECV | Sn_IR_TIMEOUT) : 0);
+    }
+
+    g_interrupt_callback = callback;
+}
+
+bool wizchip_gpio_interrupt_pending(void)
+{
+    return w5500_sim_get_interrupts() != 0;
+}
+
+/* No SPI bus, the simulator counts its transactions itself */
+void wizchip_spi_get_stats(wizchip_spi_stats_t *stats)
+{
+    memset(stats, 0, sizeof(wizchip_spi_stats_t));
+}
+
+/* The log of the server and ventcontrol */
+int server_bench_log(const char *format, ...)
+{
+    va_list args;
+    int ret = 0;
+
+    if (g_log)
+    {
+        va_start(args, format);
+        ret = vprintf(format, args);
+        va_end(args);
+    }
+
+    return ret;
+}
@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _FIRMWARE_SIM_H_
+#define _FIRMWARE_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Firmware on the simulated W5500 */
+/*! \brief Set the clock of the firmware
+ *  \ingroup firmware_sim
+ *
+ *  time_us_64 returns the monotonic clock of the host until a benchmark hands it the simulated time
+ *  it steps.
+ *
+ *  \param now_us simulated time in us, NULL for the clock of the host
+ */
+void firmware_sim_set_clock(const uint64_t *now_us);
+
+/*! \brief Print the log of the firmware
+ *  \ingroup firmware_sim
+ *
+ *  The host build maps printf of the server sources to server_bench_log, which discards the log
+ *  until it is enabled.
+ *
+ *  \param enabled true to print the log on stdout
+ */
+void firmware_sim_set_log(bool enabled);
+
+/*! \brief Raise the INT pin
+ *  \ingroup firmware_sim
+ *
+ *  Call the callback that the server registered with wizchip_gpio_interrupt_initialize_mask,
+ *  nothing while none is registered.
+ */
+void firmware_sim_interrupt(void);
+
+#endif /* _FIRMWARE_SIM_H_ */
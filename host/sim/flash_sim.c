@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <string.h>
+
+#include "flash_sim.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+static uint8_t g_flash[FLASH_REGION_SIZE];
+static flash_sim_stats_t g_stats;
+static bool g_initialized = false;
+static bool g_cut_armed = false;
+static bool g_cut = false;
+static uint32_t g_cut_operations;
+static uint32_t g_cut_bytes;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Bytes of the next operation that reach the flash, all of them without a cut */
+static uint32_t flash_sim_operation(uint32_t size)
+{
+    if (g_cut)
+    {
+        return 0;
+    }
+
+    if (g_cut_armed && g_cut_operations-- == 0)
+    {
+        g_cut_armed = false;
+        g_cut = true;
+        g_stats.cuts++;
+
+        return (g_cut_bytes < size) ? g_cut_bytes : size;
+    }
+
+    return size;
+}
+
+void flash_sim_initialize(void)
+{
+    memset(g_flash, 0xff, sizeof(g_flash));
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_initialized = true;
+    g_cut_armed = false;
+    g_cut = false;
+}
+
+void flash_sim_cut_power(uint32_t operations, uint32_t bytes)
+{
+    g_cut_armed = true;
+    g_cut_operations = operations;
+    g_cut_bytes = bytes;
+}
+
+void flash_sim_power_on(void)
+{
+    g_cut_armed = false;
+    g_cut = false;
+}
+
+bool flash_sim_power_cut(void)
+{
+    return g_cut;
+}
+
+void flash_sim_get_stats(flash_sim_stats_t *stats)
+{
+    *stats = g_stats;
+}
+
+/* Firmware */
+bool flash_region_initialize(void)
+{
+    // A region the program never initialized is a new chip
+    if (!g_initialized)
+    {
+        flash_sim_initialize();
+    }
+
+    return true;
+}
+
+void flash_region_read(uint32_t offset, void *data, uint32_t size)
+{
+    if (offset + size > FLASH_REGION_SIZE)
+    {
+        g_stats.errors++;
+        memset(data, 0xff, size);
+        return;
+    }
+
+    memcpy(data, g_flash + offset, size);
+    g_stats.reads++;
+    g_stats.read_bytes += size;
+}
+
+void flash_region_erase(uint8_t sector)
+{
+    if (sector >= FLASH_REGION_SECTORS)
+    {
+        g_stats.errors++;
+        return;
+    }
+
+    uint32_t size = flash_sim_operation(FLASH_REGION_SECTOR_SIZE);
+
+    memset(g_flash + sector * FLASH_REGION_SECTOR_SIZE, 0xff, size);
+    g_stats.erases[sector] += (size > 0) ? 1 : 0;
+}
+
+void flash_region_program(uint32_t offset, const uint8_t *page)
+{
+    if ((offset % FLASH_REGION_PAGE_SIZE) != 0 || offset >= FLASH_REGION_SIZE)
+    {
+        g_stats.errors++;
+        return;
+    }
+
+    uint32_t size = flash_sim_operation(FLASH_REGION_PAGE_SIZE);
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        // A program only clears bits, a 1 over a 0 stays 0. 0xff leaves the byte as it is.
+        g_stats.errors += (page[i] != 0xff && (page[i] & ~g_flash[offset + i])) ? 1 : 0;
+        g_flash[offset + i] &= page[i];
+    }
+    g_stats.programs += (size > 0) ? 1 : 0;
+}
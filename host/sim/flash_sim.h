@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _FLASH_SIM_H_
+#define _FLASH_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "flash_region.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+typedef struct flash_sim_stats_t
+{
+    uint32_t erases[FLASH_REGION_SECTORS];  // per sector, the wear of the region
+    uint32_t programs;                      // page programs
+    uint32_t reads;
+    uint64_t read_bytes;
+    uint32_t cuts;                          // operations a power cut interrupted
+    uint32_t errors;                        // unaligned operations and programs of a byte that needed a 0 bit back to 1
+} flash_sim_stats_t;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Simulated flash region */
+/*! \brief Initialize the simulated flash region
+ *  \ingroup flash_sim
+ *
+ *  The flash_region functions of the firmware run against a RAM copy of the region with the rules of
+ *  NOR flash: an erase sets a whole sector to 0xff, a program of a page clears bits and never sets them.
+ *  The region starts blank, like a new chip, and keeps its content over flash_sim_power_on.
+ */
+void flash_sim_initialize(void);
+
+/*! \brief Cut the power in the middle of an erase or program
+ *  \ingroup flash_sim
+ *
+ *  After operations more erases or programs complete, the next one stops after bytes bytes: a program
+ *  leaves the rest of the page as it was, an erase leaves the rest of the sector as it was. From then
+ *  on the flash ignores erases and programs until flash_sim_power_on.
+ *
+ *  \param operations erases and programs that still complete
+ *  \param bytes bytes of the interrupted operation that reach the flash
+ */
+void flash_sim_cut_power(uint32_t operations, uint32_t bytes);
+
+/*! \brief Power the flash again after a cut
+ *  \ingroup flash_sim
+ *
+ *  The content stays as the cut left it, the firmware restores its state from it.
+ */
+void flash_sim_power_on(void);
+
+/*! \brief Get whether the power is cut
+ *  \ingroup flash_sim
+ *
+ *  \return true from the interrupted operation until flash_sim_power_on
+ */
+bool flash_sim_power_cut(void);
+
+/*! \brief Get the operation counters
+ *  \ingroup flash_sim
+ *
+ *  \param stats counters since initialize
+ */
+void flash_sim_get_stats(flash_sim_stats_t *stats);
+
+#endif /* _FLASH_SIM_H_ */
@@ -0,0 +1,331 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "wizchip_conf.h"
+#include "w5500_sim.h"
+#include "w5500_posix.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* The host connection of a socket of the simulated W5500 */
+typedef struct w5500_posix_socket_t
+{
+    int fd;                            // -1 without a host connection
+    uint8_t rx[W5500_POSIX_CHUNK];     // read from the host, not accepted by the RX buffer yet
+    uint16_t rx_size;
+    uint8_t tx[W5500_POSIX_CHUNK];     // sent by the W5500, not taken by the host yet
+    uint16_t tx_size;
+} w5500_posix_socket_t;
+
+typedef struct w5500_posix_listener_t
+{
+    uint16_t port;
+    int fd;
+} w5500_posix_listener_t;
+
+typedef struct w5500_posix_port_map_t
+{
+    uint16_t port;
+    uint16_t host_port;
+} w5500_posix_port_map_t;
+
+static w5500_posix_socket_t g_sockets[W5500_SIM_SOCKET_COUNT];
+static w5500_posix_listener_t g_listeners[W5500_SIM_SOCKET_COUNT];
+static uint8_t g_listener_count = 0;
+static w5500_posix_port_map_t g_port_maps[W5500_POSIX_PORT_MAPS];
+static uint8_t g_port_map_count = 0;
+static w5500_posix_stats_t g_stats;
+static bool g_initialized = false;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+static void w5500_posix_close(uint8_t sn)
+{
+    close(g_sockets[sn].fd);
+    g_sockets[sn].fd = -1;
+    g_sockets[sn].rx_size = 0;
+    g_sockets[sn].tx_size = 0;
+}
+
+/* One host listener per port, the W5500 lets several sockets listen on the same port */
+static void w5500_posix_listen(uint16_t port)
+{
+    struct sockaddr_in addr = {0};
+    int one = 1;
+
+    for (uint8_t i = 0; i < g_listener_count; i++)
+    {
+        if (g_listeners[i].port == port)
+        {
+            return;
+        }
+    }
+
+    uint16_t host_port = port;
+
+    for (uint8_t i = 0; i < g_port_map_count; i++)
+    {
+        if (g_port_maps[i].port == port)
+        {
+            host_port = g_port_maps[i].host_port;
+        }
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(host_port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, W5500_POSIX_BACKLOG) < 0)
+    {
+        printf("Unable to listen on host port %d: %s\n", host_port, strerror(errno));
+        close(fd);
+        fd = -1;
+    }
+
+    // A port that failed is not tried again
+    g_listeners[g_listener_count].port = port;
+    g_listeners[g_listener_count].fd = fd;
+    g_listener_count++;
+}
+
+static void w5500_posix_accept(const w5500_posix_listener_t *listener)
+{
+    int fd;
+    int one = 1;
+
+    while ((fd = accept(listener->fd, NULL, NULL)) >= 0)
+    {
+        int sn = w5500_sim_accept(listener->port);
+
+        if (sn < 0)
+        {
+            struct linger reset = {1, 0};
+
+            setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+            close(fd);
+            g_stats.refused++;
+            continue;
+        }
+
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        g_sockets[sn].fd = fd;
+        g_sockets[sn].rx_size = 0;
+        g_sockets[sn].tx_size = 0;
+        g_stats.accepted++;
+    }
+}
+
+/* Host data into the RX buffer, what does not fit waits for the server to read */
+static void w5500_posix_receive(uint8_t sn, bool readable)
+{
+    w5500_posix_socket_t *host = &g_sockets[sn];
+
+    if (host->rx_size == 0 && readable)
+    {
+        ssize_t size = read(host->fd, host->rx, sizeof(host->rx));
+
+        if (size == 0 || (size < 0 && errno != EAGAIN && errno != EINTR))
+        {
+            w5500_sim_disconnect(sn);
+            w5500_posix_close(sn);
+            g_stats.disconnected++;
+            return;
+        }
+
+        host->rx_size = (size > 0) ? size : 0;
+        g_stats.received_bytes += host->rx_size;
+    }
+
+    uint16_t accepted = w5500_sim_receive(sn, host->rx, host->rx_size);
+
+    memmove(host->rx, host->rx + accepted, host->rx_size - accepted);
+    host->rx_size -= accepted;
+}
+
+/* Data of the SEND commands to the host, a socket that left ESTABLISHED closes its host connection */
+static void w5500_posix_transmit(uint8_t sn)
+{
+    w5500_posix_socket_t *host = &g_sockets[sn];
+
+    while (true)
+    {
+        if (host->tx_size == 0)
+        {
+            host->tx_size = w5500_sim_take_sent(sn, host->tx, sizeof(host->tx));
+        }
+
+        if (host->tx_size == 0)
+        {
+            break;
+        }
+
+        ssize_t size = send(host->fd, host->tx, host->tx_size, MSG_NOSIGNAL);
+
+        if (size <= 0)
+        {
+            break;
+        }
+
+        memmove(host->tx, host->tx + size, host->tx_size - size);
+        host->tx_size -= size;
+        g_stats.sent_bytes += size;
+    }
+
+    uint8_t status = w5500_sim_get_status(sn);
+
+    if (status != SOCK_ESTABLISHED && status != SOCK_CLOSE_WAIT)
+    {
+        w5500_posix_close(sn);
+        g_stats.closed++;
+    }
+}
+
+void w5500_posix_initialize(void)
+{
+    for (uint8_t sn = 0; sn < W5500_SIM_SOCKET_COUNT; sn++)
+    {
+        if (g_initialized && g_sockets[sn].fd >= 0)
+        {
+            close(g_sockets[sn].fd);
+        }
+        g_sockets[sn].fd = -1;
+        g_sockets[sn].rx_size = 0;
+        g_sockets[sn].tx_size = 0;
+    }
+
+    for (uint8_t i = 0; i < g_listener_count; i++)
+    {
+        if (g_listeners[i].fd >= 0)
+        {
+            close(g_listeners[i].fd);
+        }
+    }
+
+    g_listener_count = 0;
+    g_port_map_count = 0;
+    g_initialized = true;
+    memset(&g_stats, 0, sizeof(g_stats));
+}
+
+void w5500_posix_map_port(uint16_t port, uint16_t host_port)
+{
+    if (g_port_map_count < W5500_POSIX_PORT_MAPS)
+    {
+        g_port_maps[g_port_map_count].port = port;
+        g_port_maps[g_port_map_count].host_port = host_port;
+        g_port_map_count++;
+    }
+}
+
+bool w5500_posix_poll(int timeout_ms)
+{
+    struct pollfd fds[W5500_SIM_SOCKET_COUNT * 2];
+    uint8_t owners[W5500_SIM_SOCKET_COUNT * 2];
+    nfds_t count = 0;
+
+    for (uint8_t sn = 0; sn < W5500_SIM_SOCKET_COUNT; sn++)
+    {
+        if (g_sockets[sn].fd >= 0)
+        {
+            w5500_posix_transmit(sn);
+        }
+
+        if (w5500_sim_get_status(sn) == SOCK_LISTEN)
+        {
+            w5500_posix_listen(w5500_sim_get_port(sn));
+        }
+    }
+
+    for (uint8_t i = 0; i < g_listener_count; i++)
+    {
+        if (g_listeners[i].fd >= 0)
+        {
+            fds[count].fd = g_listeners[i].fd;
+            fds[count].events = POLLIN;
+            owners[count++] = W5500_SIM_SOCKET_COUNT + i;
+        }
+    }
+
+    for (uint8_t sn = 0; sn < W5500_SIM_SOCKET_COUNT; sn++)
+    {
+        w5500_posix_socket_t *host = &g_sockets[sn];
+
+        if (host->fd < 0)
+        {
+            continue;
+        }
+
+        // Bytes that wait for room in the RX buffer are tried again soon, the server reads in between
+        if (host->rx_size > 0 && timeout_ms > 1)
+        {
+            timeout_ms = 1;
+        }
+
+        fds[count].fd = host->fd;
+        fds[count].events = ((host->rx_size == 0) ? POLLIN : 0) | ((host->tx_size > 0) ? POLLOUT : 0);
+        owners[count++] = sn;
+    }
+
+    poll(fds, count, timeout_ms);
+
+    for (nfds_t i = 0; i < count; i++)
+    {
+        if (owners[i] >= W5500_SIM_SOCKET_COUNT)
+        {
+            if (fds[i].revents & POLLIN)
+            {
+                w5500_posix_accept(&g_listeners[owners[i] - W5500_SIM_SOCKET_COUNT]);
+            }
+            continue;
+        }
+
+        uint8_t sn = owners[i];
+
+        if (g_sockets[sn].fd >= 0)
+        {
+            w5500_posix_receive(sn, fds[i].revents & (POLLIN | POLLHUP | POLLERR));
+        }
+
+        if (g_sockets[sn].fd >= 0 && (fds[i].revents & POLLOUT))
+        {
+            w5500_posix_transmit(sn);
+        }
+    }
+
+    return w5500_sim_get_interrupts() != 0;
+}
+
+void w5500_posix_get_stats(w5500_posix_stats_t *stats)
+{
+    *stats = g_stats;
+}
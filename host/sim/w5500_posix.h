@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _W5500_POSIX_H_
+#define _W5500_POSIX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Host sockets */
+#define W5500_POSIX_CHUNK 512          // bytes moved per host socket and poll
+#define W5500_POSIX_BACKLOG 16
+#define W5500_POSIX_PORT_MAPS 4
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+typedef struct w5500_posix_stats_t
+{
+    uint32_t accepted;                 // host clients that got a socket
+    uint32_t refused;                  // host clients without a listening socket, reset like the W5500 does
+    uint32_t closed;                   // host connections closed by the server
+    uint32_t disconnected;             // host clients that left, the socket went to CLOSE_WAIT
+    uint64_t received_bytes;
+    uint64_t sent_bytes;
+} w5500_posix_stats_t;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Host sockets */
+/*! \brief Initialize the host side of the simulated W5500
+ *  \ingroup w5500_posix
+ *
+ *  The eight sockets of the simulated W5500 get their peers from non-blocking BSD sockets of the
+ *  host, so the ioLibrary socket API and the server run unchanged and clients connect over TCP.
+ *  Call after w5500_sim_initialize. Host sockets of an earlier run are closed.
+ */
+void w5500_posix_initialize(void);
+
+/*! \brief Listen on another host port for a port of the W5500
+ *  \ingroup w5500_posix
+ *
+ *  Without a mapping the host listens on the Sn_PORT of the sockets. Set before the first poll
+ *  that sees the port listening.
+ *
+ *  \param port TCP port the sockets of the simulated W5500 listen on
+ *  \param host_port TCP port of the host clients connect to
+ */
+void w5500_posix_map_port(uint16_t port, uint16_t host_port);
+
+/*! \brief Move connections and data between the host and the simulated W5500
+ *  \ingroup w5500_posix
+ *
+ *  - A TCP socket in SOCK_LISTEN gets a host listener on its Sn_PORT, shared by all sockets on the port.
+ *  - A host client takes the first socket that listens on the port, SOCK_ESTABLISHED and Sn_IR_CON.
+ *    Without one the client is reset.
+ *  - Host data goes into the RX buffer as far as the window of the socket allows, with Sn_IR_RECV.
+ *  - Data of every SEND command goes to the host client.
+ *  - A host client that leaves puts the socket in SOCK_CLOSE_WAIT with Sn_IR_DISCON.
+ *  - A socket the server disconnects or closes closes the host connection.
+ *
+ *  UDP sockets have no host peer.
+ *
+ *  \param timeout_ms longest wait for a host socket event, 0 to only move what is ready
+ *  \return true while a socket interrupt is pending, the INT pin of the W5500 is low
+ */
+bool w5500_posix_poll(int timeout_ms);
+
+/*! \brief Get the host socket counters
+ *  \ingroup w5500_posix
+ *
+ *  \param stats counters since initialize
+ */
+void w5500_posix_get_stats(w5500_posix_stats_t *stats);
+
+#endif /* _W5500_POSIX_H_ */
@@ -0,0 +1,465 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "wizchip_conf.h"
+#include "w5500_sim.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* SPI frame */
+#define SIM_HEADER_SIZE 3
+#define SIM_CONTROL_RWB 0x04
+
+/* Block select */
+#define SIM_BSB_COMMON 0x00
+#define SIM_BSB_REG 0x01
+#define SIM_BSB_TX 0x02
+#define SIM_BSB_RX 0x03
+
+/* Common registers */
+#define SIM_COMMON_SIR 0x17
+#define SIM_COMMON_VERSIONR 0x39
+
+/* Socket registers */
+#define SIM_SN_MR 0x00
+#define SIM_SN_CR 0x01
+#define SIM_SN_IR 0x02
+#define SIM_SN_SR 0x03
+#define SIM_SN_PORT 0x04
+#define SIM_SN_RXBUF_SIZE 0x1E
+#define SIM_SN_TXBUF_SIZE 0x1F
+#define SIM_SN_TX_FSR 0x20
+#define SIM_SN_TX_RD 0x22
+#define SIM_SN_TX_WR 0x24
+#define SIM_SN_RX_RSR 0x26
+#define SIM_SN_RX_RD 0x28
+#define SIM_SN_RX_WR 0x2A
+#define SIM_SN_IMR 0x2C
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+typedef struct w5500_sim_socket_t
+{
+    uint8_t regs[W5500_SIM_SOCKET_REG_SIZE];
+    uint8_t tx[W5500_SIM_BUF_SIZE];
+    uint8_t rx[W5500_SIM_BUF_SIZE];
+    uint8_t peer[W5500_SIM_PEER_SIZE];
+    uint16_t peer_size;
+} w5500_sim_socket_t;
+
+static uint8_t g_common[W5500_SIM_COMMON_SIZE];
+static w5500_sim_socket_t g_socket[W5500_SIM_SOCKET_COUNT];
+
+/* Current SPI frame */
+static uint8_t g_header[SIM_HEADER_SIZE];
+static uint8_t g_header_len = 0;
+static uint16_t g_addr = 0;
+
+/* Counters */
+static uint32_t g_transaction_count = 0;
+static uint32_t g_byte_count = 0;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+static uint16_t w5500_sim_get16(const uint8_t *regs, uint8_t offset)
+{
+    return ((uint16_t)regs[offset] << 8) | regs[offset + 1];
+}
+
+static void w5500_sim_set16(uint8_t *regs, uint8_t offset, uint16_t value)
+{
+    regs[offset] = (uint8_t)(value >> 8);
+    regs[offset + 1] = (uint8_t)value;
+}
+
+static void w5500_sim_update_sizes(w5500_sim_socket_t *socket)
+{
+    uint16_t tx_used = w5500_sim_get16(socket->regs, SIM_SN_TX_WR) - w5500_sim_get16(socket->regs, SIM_SN_TX_RD);
+    uint16_t rx_used = w5500_sim_get16(socket->regs, SIM_SN_RX_WR) - w5500_sim_get16(socket->regs, SIM_SN_RX_RD);
+
+    w5500_sim_set16(socket->regs, SIM_SN_TX_FSR, W5500_SIM_BUF_SIZE - tx_used);
+    w5500_sim_set16(socket->regs, SIM_SN_RX_RSR, rx_used);
+}
+
+static void w5500_sim_update_sir(void)
+{
+    uint8_t sir = 0;
+
+    for (int sn = 0; sn < W5500_SIM_SOCKET_COUNT; sn++)
+    {
+        if (g_socket[sn].regs[SIM_SN_IR] & g_socket[sn].regs[SIM_SN_IMR])
+        {
+            sir |= (1 << sn);
+        }
+    }
+
+    g_common[SIM_COMMON_SIR] = sir;
+}
+
+static void w5500_sim_command(uint8_t sn, uint8_t command)
+{
+    w5500_sim_socket_t *socket = &g_socket[sn];
+
+    switch (command)
+    {
+    case Sn_CR_OPEN:
+        memset(socket->regs + SIM_SN_TX_FSR, 0, SIM_SN_IMR - SIM_SN_TX_FSR);
+        socket->regs[SIM_SN_SR] = ((socket->regs[SIM_SN_MR] & 0x0F) == Sn_MR_TCP) ? SOCK_INIT : SOCK_UDP;
+        socket->peer_size = 0;
+        break;
+
+    case Sn_CR_LISTEN:
+        if (socket->regs[SIM_SN_SR] == SOCK_INIT)
+        {
+            socket->regs[SIM_SN_SR] = SOCK_LISTEN;
+        }
+        break;
+
+    case Sn_CR_DISCON:
+    case Sn_CR_CLOSE:
+        socket->regs[SIM_SN_SR] = SOCK_CLOSED;
+        break;
+
+    case Sn_CR_SEND:
+    {
+        uint16_t rd = w5500_sim_get16(socket->regs, SIM_SN_TX_RD);
+        uint16_t wr = w5500_sim_get16(socket->regs, SIM_SN_TX_WR);
+
+        for (; rd != wr; rd++)
+        {
+            if (socket->peer_size < W5500_SIM_PEER_SIZE)
+            {
+                socket->peer[socket->peer_size++] = socket->tx[rd % W5500_SIM_BUF_SIZE];
+            }
+        }
+
+        w5500_sim_set16(socket->regs, SIM_SN_TX_RD, rd);
+        socket->regs[SIM_SN_IR] |= Sn_IR_SENDOK;
+        break;
+    }
+
+    case Sn_CR_RECV:
+        // Data left after the new read pointer raises RECV again
+        if (w5500_sim_get16(socket->regs, SIM_SN_RX_WR) != w5500_sim_get16(socket->regs, SIM_SN_RX_RD))
+        {
+            socket->regs[SIM_SN_IR] |= Sn_IR_RECV;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    w5500_sim_update_sizes(socket);
+    w5500_sim_update_sir();
+}
+
+static uint8_t *w5500_sim_locate(uint8_t *writable)
+{
+    uint8_t bsb = g_header[2] >> 3;
+    uint8_t sn = bsb >> 2;
+    uint16_t addr = g_addr++;
+
+    *writable = 1;
+
+    if (bsb == SIM_BSB_COMMON)
+    {
+        *writable = (addr != SIM_COMMON_SIR) && (addr != SIM_COMMON_VERSIONR);
+
+        return &g_common[addr % W5500_SIM_COMMON_SIZE];
+    }
+
+    switch (bsb & 0x03)
+    {
+    case SIM_BSB_REG:
+        return &g_socket[sn].regs[addr % W5500_SIM_SOCKET_REG_SIZE];
+
+    case SIM_BSB_TX:
+        return &g_socket[sn].tx[addr % W5500_SIM_BUF_SIZE];
+
+    case SIM_BSB_RX:
+        *writable = 0;
+
+        return &g_socket[sn].rx[addr % W5500_SIM_BUF_SIZE];
+
+    default:
+        *writable = 0;
+
+        return &g_common[0];
+    }
+}
+
+static void w5500_sim_write(uint8_t data)
+{
+    uint8_t bsb = g_header[2] >> 3;
+    uint8_t sn = bsb >> 2;
+    uint16_t addr = g_addr;
+    uint8_t writable;
+    uint8_t *target = w5500_sim_locate(&writable);
+
+    if (!writable)
+    {
+        return;
+    }
+
+    if ((bsb & 0x03) == SIM_BSB_REG)
+    {
+        switch (addr)
+        {
+        case SIM_SN_CR:
+            w5500_sim_command(sn, data);
+            return;
+
+        case SIM_SN_IR:
+            // Write 1 to clear
+            *target &= ~data;
+            w5500_sim_update_sir();
+            return;
+
+        case SIM_SN_SR:
+        case SIM_SN_TX_FSR:
+        case SIM_SN_TX_FSR + 1:
+        case SIM_SN_TX_RD:
+        case SIM_SN_TX_RD + 1:
+        case SIM_SN_RX_RSR:
+        case SIM_SN_RX_RSR + 1:
+        case SIM_SN_RX_WR:
+        case SIM_SN_RX_WR + 1:
+            return;
+
+        default:
+            break;
+        }
+    }
+
+    *target = data;
+}
+
+static uint8_t w5500_sim_read(void)
+{
+    uint8_t writable;
+
+    return *w5500_sim_locate(&writable);
+}
+
+static void w5500_sim_select(void)
+{
+    g_header_len = 0;
+    g_transaction_count++;
+}
+
+static void w5500_sim_deselect(void)
+{
+    g_header_len = 0;
+}
+
+static void w5500_sim_write_byte(uint8_t data)
+{
+    g_byte_count++;
+
+    if (g_header_len < SIM_HEADER_SIZE)
+    {
+        g_header[g_header_len++] = data;
+        g_addr = ((uint16_t)g_header[0] << 8) | g_header[1];
+        return;
+    }
+
+    if (g_header[2] & SIM_CONTROL_RWB)
+    {
+        w5500_sim_write(data);
+    }
+    else
+    {
+        g_addr++;
+    }
+}
+
+static uint8_t w5500_sim_read_byte(void)
+{
+    g_byte_count++;
+
+    if (g_header_len < SIM_HEADER_SIZE)
+    {
+        return 0xFF;
+    }
+
+    return w5500_sim_read();
+}
+
+static void w5500_sim_write_burst(uint8_t *buf, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        w5500_sim_write_byte(buf[i]);
+    }
+}
+
+static void w5500_sim_read_burst(uint8_t *buf, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        buf[i] = w5500_sim_read_byte();
+    }
+}
+
+static void w5500_sim_critical_section(void)
+{
+}
+
+void w5500_sim_initialize(void)
+{
+    memset(g_common, 0, sizeof(g_common));
+    memset(g_socket, 0, sizeof(g_socket));
+
+    g_common[SIM_COMMON_VERSIONR] = 0x04;
+
+    for (int sn = 0; sn < W5500_SIM_SOCKET_COUNT; sn++)
+    {
+        g_socket[sn].regs[SIM_SN_SR] = SOCK_CLOSED;
+        g_socket[sn].regs[SIM_SN_IMR] = 0xFF;
+        g_socket[sn].regs[SIM_SN_RXBUF_SIZE] = W5500_SIM_BUF_SIZE >> 10;
+        g_socket[sn].regs[SIM_SN_TXBUF_SIZE] = W5500_SIM_BUF_SIZE >> 10;
+        w5500_sim_update_sizes(&g_socket[sn]);
+    }
+
+    w5500_sim_reset_counters();
+
+    reg_wizchip_cris_cbfunc(w5500_sim_critical_section, w5500_sim_critical_section);
+    reg_wizchip_cs_cbfunc(w5500_sim_select, w5500_sim_deselect);
+    reg_wizchip_spi_cbfunc(w5500_sim_read_byte, w5500_sim_write_byte);
+    reg_wizchip_spiburst_cbfunc(w5500_sim_read_burst, w5500_sim_write_burst);
+}
+
+void w5500_sim_connect(uint8_t sn)
+{
+    if (g_socket[sn].regs[SIM_SN_SR] == SOCK_LISTEN)
+    {
+        g_socket[sn].regs[SIM_SN_SR] = SOCK_ESTABLISHED;
+        g_socket[sn].regs[SIM_SN_IR] |= Sn_IR_CON;
+        w5500_sim_update_sir();
+    }
+}
+
+int w5500_sim_accept(uint16_t port)
+{
+    for (int sn = 0; sn < W5500_SIM_SOCKET_COUNT; sn++)
+    {
+        if (g_socket[sn].regs[SIM_SN_SR] == SOCK_LISTEN && w5500_sim_get16(g_socket[sn].regs, SIM_SN_PORT) == port)
+        {
+            w5500_sim_connect(sn);
+            return sn;
+        }
+    }
+
+    return -1;
+}
+
+void w5500_sim_disconnect(uint8_t sn)
+{
+    if (g_socket[sn].regs[SIM_SN_SR] == SOCK_ESTABLISHED)
+    {
+        g_socket[sn].regs[SIM_SN_SR] = SOCK_CLOSE_WAIT;
+        g_socket[sn].regs[SIM_SN_IR] |= Sn_IR_DISCON;
+        w5500_sim_update_sir();
+    }
+}
+
+uint16_t w5500_sim_receive(uint8_t sn, const uint8_t *buf, uint16_t len)
+{
+    w5500_sim_socket_t *socket = &g_socket[sn];
+    uint16_t wr = w5500_sim_get16(socket->regs, SIM_SN_RX_WR);
+    uint16_t free = W5500_SIM_BUF_SIZE - w5500_sim_get16(socket->regs, SIM_SN_RX_RSR);
+
+    if (socket->regs[SIM_SN_SR] != SOCK_ESTABLISHED)
+    {
+        return 0;
+    }
+
+    if (len > free)
+    {
+        len = free;
+    }
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        socket->rx[wr++ % W5500_SIM_BUF_SIZE] = buf[i];
+    }
+
+    w5500_sim_set16(socket->regs, SIM_SN_RX_WR, wr);
+    w5500_sim_update_sizes(socket);
+
+    if (len > 0)
+    {
+        socket->regs[SIM_SN_IR] |= Sn_IR_RECV;
+        w5500_sim_update_sir();
+    }
+
+    return len;
+}
+
+uint16_t w5500_sim_take_sent(uint8_t sn, uint8_t *buf, uint16_t len)
+{
+    w5500_sim_socket_t *socket = &g_socket[sn];
+
+    if (len > socket->peer_size)
+    {
+        len = socket->peer_size;
+    }
+
+    memcpy(buf, socket->peer, len);
+    memmove(socket->peer, socket->peer + len, socket->peer_size - len);
+    socket->peer_size -= len;
+
+    return len;
+}
+
+uint8_t w5500_sim_get_status(uint8_t sn)
+{
+    return g_socket[sn].regs[SIM_SN_SR];
+}
+
+uint16_t w5500_sim_get_port(uint8_t sn)
+{
+    return w5500_sim_get16(g_socket[sn].regs, SIM_SN_PORT);
+}
+
+uint8_t w5500_sim_get_interrupts(void)
+{
+    return g_common[SIM_COMMON_SIR];
+}
+
+uint32_t w5500_sim_get_transaction_count(void)
+{
+    return g_transaction_count;
+}
+
+uint32_t w5500_sim_get_byte_count(void)
+{
+    return g_byte_count;
+}
+
+void w5500_sim_reset_counters(void)
+{
+    g_transaction_count = 0;
+    g_byte_count = 0;
+}
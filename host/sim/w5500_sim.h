@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _W5500_SIM_H_
+#define _W5500_SIM_H_
+
+#include <stdint.h>
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Simulated chip */
+#define W5500_SIM_SOCKET_COUNT 8
+#define W5500_SIM_COMMON_SIZE 0x40
+#define W5500_SIM_SOCKET_REG_SIZE 0x30
+#define W5500_SIM_BUF_SIZE (1024 * 2)
+#define W5500_SIM_PEER_SIZE (1024 * 16)
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Simulated chip */
+/*! \brief Initialize the simulated W5500
+ *  \ingroup w5500_sim
+ *
+ *  Reset the registers and buffers of the simulated chip and register the SPI callbacks
+ *  with the ioLibrary, so WIZCHIP_READ, WIZCHIP_WRITE and the socket API run against it.
+ *  Every socket gets the default 2 KB TX and RX buffer.
+ */
+void w5500_sim_initialize(void);
+
+/*! \brief Establish a connection on a socket
+ *  \ingroup w5500_sim
+ *
+ *  A listening socket becomes ESTABLISHED and Sn_IR_CON is set.
+ *
+ *  \param sn socket number
+ */
+void w5500_sim_connect(uint8_t sn);
+
+/*! \brief Connect a client to a port
+ *  \ingroup w5500_sim
+ *
+ *  The first socket that listens on the port takes the connection, see w5500_sim_connect.
+ *  Without a listening socket the connection is refused, the W5500 answers the SYN with a RST.
+ *
+ *  \param port TCP port of the server
+ *  \return socket number, or -1 when the connection is refused
+ */
+int w5500_sim_accept(uint16_t port);
+
+/*! \brief Close a connection from the peer side
+ *  \ingroup w5500_sim
+ *
+ *  The socket becomes CLOSE_WAIT and Sn_IR_DISCON is set.
+ *
+ *  \param sn socket number
+ */
+void w5500_sim_disconnect(uint8_t sn);
+
+/*! \brief Receive data from the peer
+ *  \ingroup w5500_sim
+ *
+ *  Append data to the RX buffer of a socket and set Sn_IR_RECV. Data that does not fit
+ *  in the free part of the RX buffer is not accepted, like a closed TCP window.
+ *
+ *  \param sn socket number
+ *  \param buf data from the peer
+ *  \param len length of the data
+ *  \return number of bytes accepted
+ */
+uint16_t w5500_sim_receive(uint8_t sn, const uint8_t *buf, uint16_t len);
+
+/*! \brief Take data sent to the peer
+ *  \ingroup w5500_sim
+ *
+ *  Data is collected for the peer by each SEND command.
+ *
+ *  \param sn socket number
+ *  \param buf buffer for the data
+ *  \param len size of buf
+ *  \return number of bytes copied
+ */
+uint16_t w5500_sim_take_sent(uint8_t sn, uint8_t *buf, uint16_t len);
+
+/*! \brief Get the status of a socket
+ *  \ingroup w5500_sim
+ *
+ *  Sn_SR without an SPI transaction, for the peer side.
+ *
+ *  \param sn socket number
+ *  \return SOCK_CLOSED, SOCK_INIT, SOCK_LISTEN, SOCK_ESTABLISHED, SOCK_CLOSE_WAIT or SOCK_UDP
+ */
+uint8_t w5500_sim_get_status(uint8_t sn);
+
+/*! \brief Get the source port of a socket
+ *  \ingroup w5500_sim
+ *
+ *  Sn_PORT without an SPI transaction, for the peer side.
+ *
+ *  \param sn socket number
+ *  \return port number
+ */
+uint16_t w5500_sim_get_port(uint8_t sn);
+
+/*! \brief Get the pending socket interrupts
+ *  \ingroup w5500_sim
+ *
+ *  SIR without an SPI transaction: a bit for every socket with an interrupt that is not masked
+ *  by its Sn_IMR, the INT pin is low while it is not 0.
+ *
+ *  \return SIR
+ */
+uint8_t w5500_sim_get_interrupts(void);
+
+/*! \brief Get the number of SPI transactions
+ *  \ingroup w5500_sim
+ *
+ *  A transaction is one chip select cycle.
+ *
+ *  \return number of transactions since initialize or the last reset
+ */
+uint32_t w5500_sim_get_transaction_count(void);
+
+/*! \brief Get the number of bytes on the SPI bus
+ *  \ingroup w5500_sim
+ *
+ *  Header and data bytes of all transactions.
+ *
+ *  \return number of bytes since initialize or the last reset
+ */
+uint32_t w5500_sim_get_byte_count(void);
+
+/*! \brief Reset the SPI counters
+ *  \ingroup w5500_sim
+ */
+void w5500_sim_reset_counters(void);
+
+#endif /* _W5500_SIM_H_ */
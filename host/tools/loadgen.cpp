@@ -0,0 +1,634 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Load generator for the control protocol on LISTENING_PORT
+ *
+ * Opens N connections and drives a mix of GET#, SETn# and HB# on each of them, open loop at a
+ * target rate or closed loop with a number of commands outstanding. GET# and SETn# are answered
+ * with S<n># in order, HB# is not answered. The server sends HB# on its own when a connection is
+ * idle for KEEP_ALIVE_SECONDS, publications are not subscribed.
+ *
+ *   loadgen [--host 192.168.11.2] [--port 1234] [--connections 4] [--seconds 10]
+ *           [--rate 10 | --closed 1] [--mix get=1,set=1,hb=0] [--keepalive 10] [--seed 1]
+ *
+ * Open loop latency is measured from the time a command was scheduled, not from the time it was
+ * written, so a stalled server is not hidden by a client that waits for it.
+ * ----------------------------------------------------------------------------------------------------
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+using TimePoint = Clock::time_point;
+
+constexpr int RECONNECT_MS = 100;
+constexpr size_t RX_MAX = 4096;
+
+struct Options
+{
+    std::string host = "192.168.11.2";
+    uint16_t port = 1234;
+    int connections = 4;
+    double seconds = 10;
+    double rate = 10;               // commands per second and connection, open loop
+    int outstanding = 0;            // commands in flight per connection, closed loop when above 0
+    double keepalive = 10;          // HB# after this many seconds without a command
+    unsigned weights[3] = {1, 1, 0};  // GET#, SETn#, HB#
+    unsigned seed = 1;
+};
+
+struct Summary
+{
+    uint64_t count = 0;
+    double sum = 0;
+    double max = 0;
+
+    void add(double value)
+    {
+        count++;
+        sum += value;
+        max = std::max(max, value);
+    }
+};
+
+struct Connection
+{
+    int fd = -1;
+    bool connecting = false;
+    bool connected = false;
+    TimePoint next_send;
+    TimePoint next_connect;
+    TimePoint last_command;
+    TimePoint last_heartbeat;
+    std::deque<TimePoint> pending;  // start times of the commands that wait for S<n>#
+    std::string rx;
+    std::string tx;
+};
+
+struct Stats
+{
+    uint64_t sent[3] = {0, 0, 0};
+    uint64_t replies = 0;
+    uint64_t unexpected = 0;
+    uint64_t connects = 0;
+    uint64_t connect_failures = 0;
+    uint64_t disconnects = 0;
+    uint64_t lost = 0;              // commands without a reply when the connection closed
+    std::vector<uint32_t> latencies_us;
+    Summary heartbeat_s;
+    uint64_t heartbeats = 0;
+};
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+void usage(const char *name)
+{
+    std::printf("usage: %s [--host address] [--port 1234] [--connections n] [--seconds s]\n"
+                "          [--rate commands/s | --closed outstanding] [--mix get=1,set=1,hb=0]\n"
+                "          [--keepalive s] [--seed n]\n", name);
+}
+
+bool parse_mix(const char *text, unsigned weights[3])
+{
+    std::string mix(text);
+    size_t start = 0;
+
+    weights[0] = weights[1] = weights[2] = 0;
+
+    while (start < mix.size())
+    {
+        size_t end = mix.find(',', start);
+        std::string item = mix.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        size_t equal = item.find('=');
+
+        if (equal == std::string::npos)
+        {
+            return false;
+        }
+
+        std::string name = item.substr(0, equal);
+        unsigned weight = std::strtoul(item.c_str() + equal + 1, nullptr, 10);
+
+        if (name == "get") weights[0] = weight;
+        else if (name == "set") weights[1] = weight;
+        else if (name == "hb") weights[2] = weight;
+        else return false;
+
+        if (end == std::string::npos)
+        {
+            break;
+        }
+        start = end + 1;
+    }
+
+    return weights[0] + weights[1] + weights[2] > 0;
+}
+
+bool parse_options(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+
+        const char *value = argv[++i];
+
+        if (arg == "--host") options.host = value;
+        else if (arg == "--port") options.port = std::atoi(value);
+        else if (arg == "--connections") options.connections = std::atoi(value);
+        else if (arg == "--seconds") options.seconds = std::atof(value);
+        else if (arg == "--rate") options.rate = std::atof(value);
+        else if (arg == "--closed") options.outstanding = std::atoi(value);
+        else if (arg == "--keepalive") options.keepalive = std::atof(value);
+        else if (arg == "--seed") options.seed = std::strtoul(value, nullptr, 10);
+        else if (arg == "--mix")
+        {
+            if (!parse_mix(value, options.weights))
+            {
+                return false;
+            }
+        }
+        else return false;
+    }
+
+    return options.connections > 0 && options.seconds > 0 && (options.outstanding > 0 || options.rate > 0);
+}
+
+class LoadGenerator
+{
+public:
+    explicit LoadGenerator(const Options &options)
+        : options_(options), random_(options.seed), connections_(options.connections)
+    {
+    }
+
+    bool run()
+    {
+        if (!resolve())
+        {
+            return false;
+        }
+
+        start_ = Clock::now();
+        end_ = start_ + seconds(options_.seconds);
+
+        for (auto &connection : connections_)
+        {
+            connection.next_connect = start_;
+        }
+
+        while (Clock::now() < end_)
+        {
+            TimePoint now = Clock::now();
+            TimePoint wake = end_;
+
+            for (auto &connection : connections_)
+            {
+                step(connection, now);
+                wake = std::min(wake, next_event(connection));
+            }
+
+            wait(wake);
+        }
+
+        elapsed_ = std::chrono::duration<double>(Clock::now() - start_).count();
+
+        for (auto &connection : connections_)
+        {
+            stats_.lost += connection.pending.size();
+            if (connection.fd >= 0)
+            {
+                ::close(connection.fd);
+            }
+        }
+
+        return true;
+    }
+
+    void print() const
+    {
+        std::vector<uint32_t> latencies = stats_.latencies_us;
+        std::sort(latencies.begin(), latencies.end());
+
+        std::string mode = (options_.outstanding > 0)
+                               ? "closed loop, " + std::to_string(options_.outstanding) + " outstanding"
+                               : "open loop, " + format(options_.rate) + " commands/s per connection";
+
+        std::printf("%d connections to %s:%d for %.1f s, %s, mix GET %u SET %u HB %u\n",
+                    options_.connections, options_.host.c_str(), options_.port, elapsed_, mode.c_str(),
+                    options_.weights[0], options_.weights[1], options_.weights[2]);
+        std::printf(" sent: %llu GET#, %llu SETn#, %llu HB#\n", (unsigned long long)stats_.sent[0],
+                    (unsigned long long)stats_.sent[1], (unsigned long long)stats_.sent[2]);
+        std::printf(" throughput: %.1f replies/s, %llu replies, %llu without reply, %llu unexpected frames\n",
+                    stats_.replies / elapsed_, (unsigned long long)stats_.replies,
+                    (unsigned long long)stats_.lost, (unsigned long long)stats_.unexpected);
+
+        if (!latencies.empty())
+        {
+            std::printf(" latency: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, max %.2f ms\n",
+                        percentile(latencies, 0.5), percentile(latencies, 0.9), percentile(latencies, 0.99),
+                        percentile(latencies, 0.999), latencies.back() / 1000.0);
+        }
+
+        std::printf(" server heartbeats: %llu, %.2f s apart on average, %.2f s at most\n",
+                    (unsigned long long)stats_.heartbeats,
+                    stats_.heartbeat_s.count ? stats_.heartbeat_s.sum / stats_.heartbeat_s.count : 0.0,
+                    stats_.heartbeat_s.max);
+        std::printf(" connections: %llu connects, %llu failed, %llu disconnects\n",
+                    (unsigned long long)stats_.connects, (unsigned long long)stats_.connect_failures,
+                    (unsigned long long)stats_.disconnects);
+    }
+
+private:
+    static Clock::duration seconds(double value)
+    {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(value));
+    }
+
+    static std::string format(double value)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%g", value);
+        return text;
+    }
+
+    static double percentile(const std::vector<uint32_t> &sorted, double fraction)
+    {
+        size_t index = std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()));
+        return sorted[index] / 1000.0;
+    }
+
+    bool resolve()
+    {
+        addrinfo hints = {};
+        addrinfo *result = nullptr;
+
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+
+        if (getaddrinfo(options_.host.c_str(), std::to_string(options_.port).c_str(), &hints, &result) != 0 || !result)
+        {
+            std::printf("Unable to resolve %s\n", options_.host.c_str());
+            return false;
+        }
+
+        std::memcpy(&address_, result->ai_addr, sizeof(address_));
+        freeaddrinfo(result);
+
+        return true;
+    }
+
+    void open(Connection &connection, TimePoint now)
+    {
+        int one = 1;
+
+        connection.fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        setsockopt(connection.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fcntl(connection.fd, F_SETFL, O_NONBLOCK);
+
+        if (::connect(connection.fd, (const sockaddr *)&address_, sizeof(address_)) < 0 && errno != EINPROGRESS)
+        {
+            fail(connection, now);
+            return;
+        }
+
+        connection.connecting = true;
+    }
+
+    void established(Connection &connection, TimePoint now)
+    {
+        connection.connecting = false;
+        connection.connected = true;
+        connection.next_send = now;
+        connection.last_command = now;
+        connection.last_heartbeat = TimePoint();
+        stats_.connects++;
+    }
+
+    void fail(Connection &connection, TimePoint now)
+    {
+        stats_.connect_failures++;
+        reset(connection, now);
+    }
+
+    void disconnected(Connection &connection, TimePoint now)
+    {
+        stats_.disconnects++;
+        stats_.lost += connection.pending.size();
+        reset(connection, now);
+    }
+
+    void reset(Connection &connection, TimePoint now)
+    {
+        if (connection.fd >= 0)
+        {
+            ::close(connection.fd);
+        }
+
+        connection.fd = -1;
+        connection.connecting = false;
+        connection.connected = false;
+        connection.pending.clear();
+        connection.rx.clear();
+        connection.tx.clear();
+        connection.next_connect = now + std::chrono::milliseconds(RECONNECT_MS);
+    }
+
+    int pick()
+    {
+        unsigned total = options_.weights[0] + options_.weights[1] + options_.weights[2];
+        unsigned value = std::uniform_int_distribution<unsigned>(0, total - 1)(random_);
+
+        for (int i = 0; i < 3; i++)
+        {
+            if (value < options_.weights[i])
+            {
+                return i;
+            }
+            value -= options_.weights[i];
+        }
+
+        return 0;
+    }
+
+    void command(Connection &connection, int kind, TimePoint start)
+    {
+        if (kind == 0)
+        {
+            connection.tx += "GET#";
+        }
+        else if (kind == 1)
+        {
+            connection.tx += "SET" + std::to_string(std::uniform_int_distribution<int>(0, 3)(random_)) + "#";
+        }
+        else
+        {
+            connection.tx += "HB#";
+        }
+
+        if (kind != 2)
+        {
+            connection.pending.push_back(start);
+        }
+
+        connection.last_command = start;
+        stats_.sent[kind]++;
+    }
+
+    void schedule(Connection &connection, TimePoint now)
+    {
+        if (options_.outstanding > 0)
+        {
+            // Closed loop: the next command when a reply came back, HB# does not wait for one
+            while ((int)connection.pending.size() < options_.outstanding)
+            {
+                command(connection, pick(), now);
+            }
+            return;
+        }
+
+        // Open loop: commands on their schedule, also the ones a slow server made late
+        while (connection.next_send <= now)
+        {
+            command(connection, pick(), connection.next_send);
+            connection.next_send += seconds(1.0 / options_.rate);
+        }
+    }
+
+    void receive(Connection &connection, TimePoint now)
+    {
+        char buf[512];
+        ssize_t size;
+
+        while ((size = ::recv(connection.fd, buf, sizeof(buf), 0)) > 0)
+        {
+            connection.rx.append(buf, size);
+        }
+
+        if (size == 0 || (size < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            disconnected(connection, now);
+            return;
+        }
+
+        size_t end;
+        while ((end = connection.rx.find('#')) != std::string::npos)
+        {
+            std::string frame = connection.rx.substr(0, end);
+            connection.rx.erase(0, end + 1);
+
+            if (frame == "HB")
+            {
+                if (connection.last_heartbeat != TimePoint())
+                {
+                    stats_.heartbeat_s.add(std::chrono::duration<double>(now - connection.last_heartbeat).count());
+                }
+                connection.last_heartbeat = now;
+                stats_.heartbeats++;
+            }
+            else if (frame.size() > 1 && frame[0] == 'S' && !connection.pending.empty())
+            {
+                auto latency = std::chrono::duration_cast<std::chrono::microseconds>(now - connection.pending.front());
+                stats_.latencies_us.push_back((uint32_t)latency.count());
+                connection.pending.pop_front();
+                stats_.replies++;
+            }
+            else
+            {
+                stats_.unexpected++;
+            }
+        }
+
+        if (connection.rx.size() > RX_MAX)
+        {
+            stats_.unexpected++;
+            connection.rx.clear();
+        }
+    }
+
+    void transmit(Connection &connection, TimePoint now)
+    {
+        while (!connection.tx.empty())
+        {
+            ssize_t size = ::send(connection.fd, connection.tx.data(), connection.tx.size(), MSG_NOSIGNAL);
+
+            if (size < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    disconnected(connection, now);
+                }
+                return;
+            }
+
+            connection.tx.erase(0, size);
+        }
+    }
+
+    void step(Connection &connection, TimePoint now)
+    {
+        if (connection.fd < 0)
+        {
+            if (now >= connection.next_connect)
+            {
+                open(connection, now);
+            }
+            return;
+        }
+
+        if (connection.connecting)
+        {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            pollfd fd = {connection.fd, POLLOUT, 0};
+
+            if (poll(&fd, 1, 0) <= 0)
+            {
+                return;
+            }
+
+            getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error != 0)
+            {
+                fail(connection, now);
+                return;
+            }
+
+            established(connection, now);
+        }
+
+        receive(connection, now);
+        if (!connection.connected)
+        {
+            return;
+        }
+
+        schedule(connection, now);
+
+        // A client that has nothing to send keeps the connection with its own heartbeat
+        if (now - connection.last_command >= seconds(options_.keepalive))
+        {
+            command(connection, 2, now);
+        }
+
+        transmit(connection, now);
+    }
+
+    TimePoint next_event(const Connection &connection) const
+    {
+        if (connection.fd < 0)
+        {
+            return connection.next_connect;
+        }
+
+        TimePoint next = connection.last_command + seconds(options_.keepalive);
+
+        if (connection.connected && options_.outstanding == 0)
+        {
+            next = std::min(next, connection.next_send);
+        }
+
+        return next;
+    }
+
+    // Sleep until the next command is due or any connection is readable, writable or connected
+    void wait(TimePoint wake)
+    {
+        std::vector<pollfd> fds;
+
+        for (const auto &connection : connections_)
+        {
+            if (connection.fd >= 0)
+            {
+                short events = POLLIN;
+                if (connection.connecting || !connection.tx.empty())
+                {
+                    events |= POLLOUT;
+                }
+                fds.push_back({connection.fd, events, 0});
+            }
+        }
+
+        auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(wake - Clock::now()).count();
+        timeout = std::max<long long>(0, std::min<long long>(timeout, 1000));
+
+        poll(fds.data(), fds.size(), (int)timeout);
+    }
+
+    Options options_;
+    std::mt19937 random_;
+    std::vector<Connection> connections_;
+    Stats stats_;
+    sockaddr_in address_ = {};
+    TimePoint start_;
+    TimePoint end_;
+    double elapsed_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    if (!parse_options(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    LoadGenerator generator(options);
+
+    if (!generator.run())
+    {
+        return 1;
+    }
+
+    generator.print();
+
+    return 0;
+}
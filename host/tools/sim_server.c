@@ -0,0 +1,209 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#include "wizchip_conf.h"
+#include "w5x00_spi.h"
+#include "w5500_sim.h"
+#include "w5500_posix.h"
+#include "firmware_sim.h"
+#include "server.h"
+#include "latency.h"
+#include "message_pool.h"
+#include "ventcontrol.h"
+#include "state_log.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Server */
+#define SIM_SERVER_QUEUE_LENGTH 64     // receive_queue and send_queue of the firmware hold MAX_QUEUE_LENGTH
+#define SIM_SERVER_MAX_WAIT_MS 100
+#define SIM_SERVER_SWEEP_US ((uint64_t)SERVER_SWEEP_TICKS * 1000)
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+typedef struct sim_queue_t
+{
+    message_t* messages[SIM_SERVER_QUEUE_LENGTH];
+    uint32_t head;
+    uint32_t tail;
+} sim_queue_t;
+
+static sim_queue_t g_receive_queue;
+static sim_queue_t g_send_queue;
+static volatile bool g_run = true;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* The queues of the firmware carry message pool pointers */
+static bool sim_queue_put(sim_queue_t *queue, message_t *message)
+{
+    if (queue->head - queue->tail == SIM_SERVER_QUEUE_LENGTH)
+    {
+        return false;
+    }
+
+    queue->messages[queue->head++ % SIM_SERVER_QUEUE_LENGTH] = message;
+
+    return true;
+}
+
+static message_t *sim_queue_get(sim_queue_t *queue)
+{
+    if (queue->head == queue->tail)
+    {
+        return NULL;
+    }
+
+    return queue->messages[queue->tail++ % SIM_SERVER_QUEUE_LENGTH];
+}
+
+static void sim_queue_send(sim_queue_t *queue, message_t *message)
+{
+    if (!sim_queue_put(queue, message))
+    {
+        message_release(message);
+    }
+}
+
+static bool sim_server_deliver(message_t *message)
+{
+    return sim_queue_put(&g_receive_queue, message);
+}
+
+static void sim_server_send(message_t *message)
+{
+    sim_queue_send(&g_send_queue, message);
+}
+
+/* ventcontrol_task: the commands queued since the last pass are one batch */
+static void sim_server_control(void)
+{
+    message_t *batch[VENTCONTROL_BATCH_SIZE];
+    uint8_t count = 0;
+
+    while (count < VENTCONTROL_BATCH_SIZE && (batch[count] = sim_queue_get(&g_receive_queue)) != NULL)
+    {
+        count++;
+    }
+
+    ventcontrol_batch(batch, count, time_us_64(), sim_server_send);
+}
+
+static void sim_server_stop(int signal)
+{
+    g_run = false;
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t ip[4] = {127, 0, 0, 1};
+    uint16_t port = LISTENING_PORT;
+    uint64_t next_poll = 0;
+    uint64_t next_sweep;
+    w5500_posix_stats_t stats;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-v"))
+        {
+            firmware_sim_set_log(true);
+        }
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+        {
+            port = atoi(argv[++i]);
+        }
+        else
+        {
+            printf("usage: %s [-p port] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, sim_server_stop);
+    signal(SIGTERM, sim_server_stop);
+
+    message_pool_initialize();
+    ventcontrol_initialize(time_us_64());
+    w5500_sim_initialize();
+    w5500_posix_initialize();
+    w5500_posix_map_port(LISTENING_PORT, port);
+    setSIPR(ip);
+    server_start(NULL);
+    next_sweep = time_us_64() + SIM_SERVER_SWEEP_US;
+
+    printf("Server logic on a simulated W5500, port %d, %d listeners\n", port, LISTENING_SOCKET_COUNT);
+
+    while (g_run)
+    {
+        uint64_t now = time_us_64();
+        int timeout_ms = SIM_SERVER_MAX_WAIT_MS;
+
+        if (next_poll <= now)
+        {
+            timeout_ms = 0;
+        }
+        else if ((next_poll - now) / 1000 < timeout_ms)
+        {
+            timeout_ms = (next_poll - now + 999) / 1000;
+        }
+
+        w5500_posix_poll(timeout_ms);
+
+        // One pass of server_task for every reply, like the firmware takes one message per poll
+        bool sweep = time_us_64() >= next_sweep;
+        if (sweep)
+        {
+            next_sweep = time_us_64() + SIM_SERVER_SWEEP_US;
+        }
+
+        message_t *send_message = sim_queue_get(&g_send_queue);
+        next_poll = server_poll(send_message, sweep, sim_server_deliver);
+        message_release(send_message);
+
+        sim_server_control();
+        while ((send_message = sim_queue_get(&g_send_queue)) != NULL)
+        {
+            next_poll = server_poll(send_message, false, sim_server_deliver);
+            message_release(send_message);
+            sim_server_control();
+        }
+    }
+
+    w5500_posix_get_stats(&stats);
+    printf("Host clients: %lu accepted, %lu refused, %lu closed by the server, %lu left\n",
+           (unsigned long)stats.accepted, (unsigned long)stats.refused, (unsigned long)stats.closed,
+           (unsigned long)stats.disconnected);
+
+    // The latency histograms of the server, printed through its log
+    server_stop();
+    firmware_sim_set_log(true);
+    latency_print_stats();
+    message_pool_print_stats();
+    ventcontrol_print_stats();
+    state_log_print_stats();
+
+    return 0;
+}
@@ -31,6 +31,27 @@
  */
 void wizchip_gpio_interrupt_initialize(uint8_t socket, void (*callback)(void));
 
+/*! \brief Initialize w5x00 gpio interrupt callback function for several sockets
+ *  \ingroup w5x00_gpio_irq
+ *
+ *  Enable the connect, disconnect, receive and timeout interrupts of every socket in socket_mask
+ *  and add a w5x00 interrupt callback. The callback runs in interrupt context.
+ *
+ *  \param socket_mask bit n set for socket n
+ *  \param callback the gpio interrupt callback function
+ */
+void wizchip_gpio_interrupt_initialize_mask(uint8_t socket_mask, void (*callback)(void));
+
+/*! \brief Get the level of the w5x00 interrupt pin
+ *  \ingroup w5x00_gpio_irq
+ *
+ *  The callback runs on the falling edge only, INT stays low while an enabled socket interrupt is pending.
+ *  An event between the read of SIR and the clear of Sn_IR raises no new edge, the caller looks again.
+ *
+ *  \return true while INT is low
+ */
+bool wizchip_gpio_interrupt_pending(void);
+
 /*! \brief Assign gpio interrupt callback function
  *  \ingroup w5x00_gpio_irq
  *
@@ -0,0 +1,248 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _W5X00_SOCKET_H_
+#define _W5X00_SOCKET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "wizchip_conf.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Socket register block */
+#define SOCKET_SNAPSHOT_SIZE 0x2C      // Sn_MR up to and including Sn_RX_WR
+#define SOCKET_SNAPSHOT_SIZES_OFFSET 0x20 // Sn_TX_FSR up to and including Sn_RX_RSR
+#define SOCKET_SNAPSHOT_SIZES_SIZE 8
+#define SOCKET_SNAPSHOT_RETRY_COUNT 4
+#define SOCKET_SNAPSHOT_RXBUF_SIZE 0x1E // Sn_RXBUF_SIZE, followed by Sn_TXBUF_SIZE
+
+/* Socket memory */
+#if (_WIZCHIP_ == W5100S)
+#define SOCKET_MEMORY_TOTAL_KB 8
+#elif (_WIZCHIP_ == W5500)
+#define SOCKET_MEMORY_TOTAL_KB 16
+#endif
+
+#define SOCKET_MEMORY_OK 0
+#define SOCKET_MEMORY_INVALID -1 // sizes are not 0, 1, 2, 4, 8 or 16 KB or exceed the total memory
+#define SOCKET_MEMORY_BUSY -2    // a socket whose buffer would move is in use
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Socket */
+typedef struct __attribute__((packed)) wizchip_socket_snapshot_t
+{
+    uint8_t mode;              // Sn_MR
+    uint8_t status;            // Sn_SR
+    uint8_t interrupt;         // Sn_IR
+    uint16_t tx_free_size;     // Sn_TX_FSR
+    uint16_t tx_read_pointer;  // Sn_TX_RD
+    uint16_t tx_write_pointer; // Sn_TX_WR
+    uint16_t rx_received_size; // Sn_RX_RSR
+    uint16_t rx_read_pointer;  // Sn_RX_RD
+    uint16_t rx_write_pointer; // Sn_RX_WR
+} wizchip_socket_snapshot_t;
+
+/* Socket memory */
+typedef struct wizchip_socket_memory_stats_t
+{
+    uint8_t tx_kb;            // Sn_TXBUF_SIZE
+    uint8_t rx_kb;            // Sn_RXBUF_SIZE
+    uint16_t tx_peak;         // most bytes waiting in the TX buffer
+    uint16_t rx_peak;         // most bytes waiting in the RX buffer
+} wizchip_socket_memory_stats_t;
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Socket */
+/*! \brief Get a 16 bit register value
+ *  \ingroup w5x00_socket
+ *
+ *  W5x00 registers are big endian.
+ *
+ *  \param buf first byte of the register
+ *  \return register value
+ */
+static uint16_t wizchip_socket_get16(const uint8_t *buf);
+
+/*! \brief Set a buffer pointer register
+ *  \ingroup w5x00_socket
+ *
+ *  Write both bytes of a pointer register in one SPI transaction.
+ *
+ *  \param addr address of the pointer register
+ *  \param pointer pointer value
+ */
+static void wizchip_socket_set_pointer(uint32_t addr, uint16_t pointer);
+
+/*! \brief Execute a socket command
+ *  \ingroup w5x00_socket
+ *
+ *  Write Sn_CR and wait until the chip has accepted the command.
+ *
+ *  \param sn socket number
+ *  \param command Sn_CR command
+ */
+static void wizchip_socket_command(uint8_t sn, uint8_t command);
+
+/*! \brief Read the state of a socket in one burst
+ *  \ingroup w5x00_socket
+ *
+ *  Read mode, status, interrupt flags, RX received size, TX free size and the buffer pointers
+ *  of a socket in one SPI transaction. The free and received sizes are read again until
+ *  two reads agree, as the datasheet requires for these registers.
+ *
+ *  \param sn socket number
+ *  \param snapshot the socket state
+ */
+void wizchip_socket_snapshot(uint8_t sn, wizchip_socket_snapshot_t *snapshot);
+
+/*! \brief Receive data using a snapshot
+ *  \ingroup w5x00_socket
+ *
+ *  Copy up to len received bytes of a TCP socket from the RX buffer, starting at the read pointer
+ *  of the snapshot, and release them with a RECV command. The snapshot is updated.
+ *
+ *  \param sn socket number
+ *  \param snapshot the socket state, from wizchip_socket_snapshot
+ *  \param buf buffer for the received data
+ *  \param len size of buf
+ *  \return number of bytes received
+ */
+int32_t wizchip_socket_recv(uint8_t sn, wizchip_socket_snapshot_t *snapshot, uint8_t *buf, uint16_t len);
+
+/*! \brief Peek at received data without releasing it
+ *  \ingroup w5x00_socket
+ *
+ *  Copy up to len received bytes, starting offset bytes after the read pointer of the snapshot,
+ *  into a caller owned window. Sn_RX_RD is not changed, so the same bytes can be read again
+ *  until they are consumed.
+ *
+ *  \param sn socket number
+ *  \param snapshot the socket state, from wizchip_socket_snapshot
+ *  \param offset offset from the read pointer
+ *  \param window buffer for the data
+ *  \param len size of window
+ *  \return number of bytes copied
+ */
+int32_t wizchip_socket_peek(uint8_t sn, const wizchip_socket_snapshot_t *snapshot, uint16_t offset, uint8_t *window, uint16_t len);
+
+/*! \brief Release received data
+ *  \ingroup w5x00_socket
+ *
+ *  Advance Sn_RX_RD past len bytes and release them with a RECV command.
+ *  Bytes after them stay in the RX buffer. The snapshot is updated.
+ *
+ *  \param sn socket number
+ *  \param snapshot the socket state, from wizchip_socket_snapshot
+ *  \param len number of bytes to release
+ *  \return number of bytes released
+ */
+int32_t wizchip_socket_consume(uint8_t sn, wizchip_socket_snapshot_t *snapshot, uint16_t len);
+
+/*! \brief Get the room for the next send
+ *  \ingroup w5x00_socket
+ *
+ *  Check whether the previous SEND was acknowledged with SENDOK and clear it. Never waits.
+ *
+ *  \param sn socket number
+ *  \param snapshot the socket state, from wizchip_socket_snapshot
+ *  \return free bytes in the TX buffer, SOCK_BUSY when the previous send is not finished,
+ *          SOCKERR_TIMEOUT when the previous send timed out
+ */
+int32_t wizchip_socket_send_space(uint8_t sn, wizchip_socket_snapshot_t *snapshot);
+
+/*! \brief Send several buffers with one SEND command
+ *  \ingroup w5x00_socket
+ *
+ *  Copy the buffers one after the other to the TX buffer of a TCP socket, starting at the write
+ *  pointer of the snapshot, and issue one SEND command for all of them, e.g. both parts of a
+ *  wrapped ring. Nothing is sent unless all of them fit. Never waits for free space.
+ *  The snapshot is updated.
+ *
+ *  \param sn socket number
+ *  \param snapshot the socket state, from wizchip_socket_snapshot
+ *  \param bufs data to send
+ *  \param lens length of each buffer
+ *  \param count number of buffers
+ *  \return total length when sent, SOCK_BUSY when there is not enough free space or the previous
+ *          send is not finished, SOCKERR_TIMEOUT when the previous send timed out
+ */
+int32_t wizchip_socket_send_segments(uint8_t sn, wizchip_socket_snapshot_t *snapshot, const uint8_t *const *bufs, const uint16_t *lens, uint8_t count);
+
+/*! \brief Send data using a snapshot
+ *  \ingroup w5x00_socket
+ *
+ *  Copy len bytes to the TX buffer of a TCP socket, starting at the write pointer of the snapshot,
+ *  and issue a SEND command. Never waits for free space. The snapshot is updated.
+ *
+ *  \param sn socket number
+ *  \param snapshot the socket state, from wizchip_socket_snapshot
+ *  \param buf data to send
+ *  \param len length of the data
+ *  \return len when sent, SOCK_BUSY when there is not enough free space or the previous send
+ *          is not finished, SOCKERR_TIMEOUT when the previous send timed out
+ */
+int32_t wizchip_socket_send(uint8_t sn, wizchip_socket_snapshot_t *snapshot, const uint8_t *buf, uint16_t len);
+
+/*! \brief Forget the send state of a socket
+ *  \ingroup w5x00_socket
+ *
+ *  Opening a socket clears Sn_IR, so a SEND that was not acknowledged before the socket closed
+ *  never gets its SENDOK. Call this before a socket is opened again.
+ *
+ *  \param sn socket number
+ */
+void wizchip_socket_reset(uint8_t sn);
+
+/* Socket memory */
+/*! \brief Check whether a socket buffer can move
+ *  \ingroup w5x00_socket
+ *
+ *  A socket without a connection or data, closed, initialized or listening, can get
+ *  a new buffer address and size.
+ *
+ *  \param sn socket number
+ *  \return true when the socket is idle
+ */
+static bool wizchip_socket_memory_idle(uint8_t sn);
+
+/*! \brief Partition the socket memory
+ *  \ingroup w5x00_socket
+ *
+ *  Set the TX and RX buffer size of every socket without a software reset. The buffers are
+ *  laid out in socket order, so a new size moves the buffers of all following sockets.
+ *  Only sockets whose buffer address or size changes have to be idle, the others keep
+ *  working. The peak use of the sockets is reset.
+ *
+ *  \param tx_kb TX buffer size of each socket in KB
+ *  \param rx_kb RX buffer size of each socket in KB
+ *  \return SOCKET_MEMORY_OK, SOCKET_MEMORY_INVALID or SOCKET_MEMORY_BUSY
+ */
+int8_t wizchip_socket_set_memory(const uint8_t *tx_kb, const uint8_t *rx_kb);
+
+/*! \brief Get the buffer sizes and peak use of a socket
+ *  \ingroup w5x00_socket
+ *
+ *  The peak use is taken from the snapshots since the last partitioning.
+ *
+ *  \param sn socket number
+ *  \param stats the buffer sizes and peak use
+ */
+void wizchip_socket_get_memory_stats(uint8_t sn, wizchip_socket_memory_stats_t *stats);
+
+#endif /* _W5X00_SOCKET_H_ */
@@ -21,9 +21,66 @@
 #define PIN_CS 17
 #define PIN_RST 20
 
+/* SPI clock */
+#define SPI_CLOCK_DEFAULT_HZ (5000 * 1000)
+#define SPI_CLOCK_MAX_HZ (33000 * 1000)   // W5500 guaranteed SCLK
+#define SPI_CLOCK_SAFETY_MARGIN_PERCENT 20 // below the fastest verified rate
+#define SPI_CLOCK_CALIBRATE                // if you want a fixed SPI_CLOCK_DEFAULT_HZ clock, comment.
+
+/* SPI clock calibration, W5500 only: other chips keep SPI_CLOCK_DEFAULT_HZ */
+#define SPI_CALIBRATION_ROUNDS 16
+#define SPI_CALIBRATION_BURST_SIZE 64
+#define SPI_CALIBRATION_SOCKET 7                                      // must not be used during calibration
+#define SPI_CALIBRATION_SCRATCH_REG Sn_MSSR(SPI_CALIBRATION_SOCKET)   // read/write while the socket is closed
+#define SPI_CALIBRATION_SCRATCH_MEM (WIZCHIP_TXBUF_BLOCK(SPI_CALIBRATION_SOCKET) << 3)
+#define SPI_MEASURE_SIZE (1024 * 2)
+
+/* SPI frame */
+#define SPI_FRAME_HEADER_SIZE 3 // 16 bit address + control byte
+#define SPI_FIFO_DEPTH 8
+#define SPI_FRAME_DMA_MIN_LEN 32 // shorter data phases are sent through the FIFO (with USE_SPI_DMA)
+
 /* Use SPI DMA */
 //#define USE_SPI_DMA // if you want to use SPI DMA, uncomment.
 
+/* Bursts shorter than this are polled, longer ones block the calling task until the DMA interrupt */
+#define SPI_DMA_ASYNC_MIN_LEN 256
+/* Task notification index used to signal DMA completion */
+#define SPI_DMA_NOTIFY_INDEX 1
+/* Fallback to a blocking wait when the completion interrupt does not arrive in time */
+#define SPI_DMA_TIMEOUT_MS 100
+
+/* Benchmark the CPU time handed back to other tasks during DMA bursts */
+//#define USE_SPI_DMA_BENCHMARK // if you want to run the SPI DMA benchmark, uncomment. Needs USE_SPI_DMA, the build adds w5x00_spi_bench.c
+
+/* SPI statistics, by the block the frame addresses */
+#define SPI_STATS_CLASS_REGISTER 0 // common and socket registers
+#define SPI_STATS_CLASS_BUFFER 1   // socket TX and RX buffers
+#define SPI_STATS_CLASS_COUNT 2
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* SPI statistics */
+typedef struct wizchip_spi_class_stats_t
+{
+    uint32_t transactions;       // frames, one per chip select
+    uint32_t bytes_read;         // data phase bytes read
+    uint32_t bytes_written;      // header and data phase bytes written
+    uint32_t max_transaction_us; // longest chip select low time
+} wizchip_spi_class_stats_t;
+
+typedef struct wizchip_spi_stats_t
+{
+    wizchip_spi_class_stats_t classes[SPI_STATS_CLASS_COUNT];
+    uint32_t single_calls;       // byte read and write callbacks
+    uint32_t burst_calls;        // burst read and write callbacks
+    uint32_t locked_us;          // time the W5x00 lock was held, wraps after 71 minutes
+    uint32_t max_locked_us;      // longest time the W5x00 lock was held
+} wizchip_spi_stats_t;
+
 /**
  * ----------------------------------------------------------------------------------------------------
  * Functions
@@ -34,6 +91,7 @@
  *  \ingroup w5x00_spi
  *
  *  Set chip select pin of spi0 to low(Active low).
+ *  Start collecting the address and control phase of a new frame.
  *
  *  \param none
  */
@@ -48,11 +106,44 @@ static inline void wizchip_select(void);
  */
 static inline void wizchip_deselect(void);
 
+/*! \brief Transfer a frame through the SPI FIFO
+ *  \ingroup w5x00_spi
+ *
+ *  Send the collected header followed by the data phase in one uninterrupted FIFO transfer.
+ *
+ *  \param tx_data data phase to send, NULL to send 0xFF
+ *  \param rx_data buffer for the received data phase, NULL to discard
+ *  \param len length of the data phase
+ */
+static void wizchip_frame_transfer_fifo(const uint8_t *tx_data, uint8_t *rx_data, uint16_t len);
+
+/*! \brief Transfer a frame
+ *  \ingroup w5x00_spi
+ *
+ *  Send the collected header followed by the data phase as one SPI transaction.
+ *  Data phases of SPI_FRAME_DMA_MIN_LEN bytes or more use a chained DMA transfer (with USE_SPI_DMA).
+ *
+ *  \param tx_data data phase to send, NULL to send 0xFF
+ *  \param rx_data buffer for the received data phase, NULL to discard
+ *  \param len length of the data phase
+ */
+static void wizchip_frame_transfer(const uint8_t *tx_data, uint8_t *rx_data, uint16_t len);
+
+/*! \brief Collect the frame header
+ *  \ingroup w5x00_spi
+ *
+ *  Take the address and control bytes written by the ioLibrary after chip select.
+ *
+ *  \param tx_data bytes written by the ioLibrary
+ *  \param len number of bytes written
+ *  \return number of bytes taken as header
+ */
+static uint16_t wizchip_frame_collect_header(const uint8_t *tx_data, uint16_t len);
+
 /*! \brief Read from an SPI device, blocking
  *  \ingroup w5x00_spi
  *
- *  Set spi_read_blocking function.
- *  Read byte from SPI to rx_data buffer.
+ *  Read one byte, together with the pending header when this is the data phase of a frame.
  *  Blocks until all data is transferred. No timeout, as SPI hardware always transfers at a known data rate.
  *
  *  \param none
@@ -62,57 +153,128 @@ static uint8_t wizchip_read(void);
 /*! \brief Write to an SPI device, blocking
  *  \ingroup w5x00_spi
  *
- *  Set spi_write_blocking function.
- *  Write byte from tx_data buffer to SPI device.
+ *  Collect a header byte or write one byte together with the pending header.
  *  Blocks until all data is transferred. No timeout, as SPI hardware always transfers at a known data rate.
  *
  *  \param tx_data Buffer of data to write
  */
 static void wizchip_write(uint8_t tx_data);
 
-#ifdef USE_SPI_DMA
-/*! \brief Configure all DMA parameters and optionally start transfer
+/*! \brief Read a burst from an SPI device
  *  \ingroup w5x00_spi
  *
- *  Configure all DMA parameters and read from DMA
+ *  Read the data phase of a frame, together with the pending header.
  *
  *  \param pBuf Buffer of data to read
  *  \param len element count (each element is of size transfer_data_size)
  */
 static void wizchip_read_burst(uint8_t *pBuf, uint16_t len);
 
-/*! \brief Configure all DMA parameters and optionally start transfer
+/*! \brief Write a burst to an SPI device
  *  \ingroup w5x00_spi
  *
- *  Configure all DMA parameters and write to DMA
+ *  Collect the header and write the remaining bytes as the data phase of a frame.
  *
  *  \param pBuf Buffer of data to write
  *  \param len element count (each element is of size transfer_data_size)
  */
 static void wizchip_write_burst(uint8_t *pBuf, uint16_t len);
+
+#ifdef USE_SPI_DMA
+/*! \brief DMA completion interrupt handler
+ *  \ingroup w5x00_spi
+ *
+ *  Acknowledge the RX channel interrupt and notify the task waiting for the burst.
+ *
+ *  \param none
+ */
+static void wizchip_dma_irq_handler(void);
+
+/*! \brief Start the configured DMA channels and wait for completion
+ *  \ingroup w5x00_spi
+ *
+ *  Short transfers are polled.
+ *  Transfers of SPI_DMA_ASYNC_MIN_LEN bytes or more block the calling task until the DMA completion
+ *  interrupt, so other tasks can run during the transfer.
+ *
+ *  \param start_mask DMA channels to start
+ *  \param len element count of the data phase
+ */
+static void wizchip_dma_transfer(uint32_t start_mask, uint16_t len);
+
+/*! \brief Transfer a frame with chained DMA
+ *  \ingroup w5x00_spi
+ *
+ *  Configure the data channels, and the header channels that chain into them,
+ *  so header and data phase go out as one DMA transfer.
+ *
+ *  \param tx_data data phase to send, NULL to send 0xFF
+ *  \param rx_data buffer for the received data phase, NULL to discard
+ *  \param len length of the data phase
+ */
+static void wizchip_frame_transfer_dma(const uint8_t *tx_data, uint8_t *rx_data, uint16_t len);
+
+/*! \brief Set the minimum burst length that yields to the scheduler
+ *  \ingroup w5x00_spi
+ *
+ *  Bursts shorter than len are polled, longer bursts wait for the DMA completion interrupt.
+ *  Use 0xFFFF to poll every transfer.
+ *
+ *  \param len minimum length of an interrupt driven burst
+ */
+void wizchip_spi_set_dma_async_min_len(uint16_t len);
+
+#ifdef USE_SPI_DMA_BENCHMARK
+/*! \brief SPI DMA benchmark task
+ *  \ingroup w5x00_spi
+ *
+ *  Read 2 KB socket buffers with polled and with interrupt driven DMA and report
+ *  how much CPU time a lower priority task received in both modes.
+ *
+ *  \param argument unused
+ */
+void wizchip_dma_benchmark_task(void *argument);
+#endif
 #endif
 
-/*! \brief Enter a critical section
+/*! \brief Take the W5x00 bus
  *  \ingroup w5x00_spi
  *
- *  Set ciritical section enter blocking function.
- *  If the spin lock associated with this critical section is in use, then this
- *  method will block until it is released.
+ *  When the scheduler is running, take the bus mutex. Interrupts stay enabled and a lower
+ *  priority owner inherits the priority of a higher priority task waiting for the bus.
+ *  Before the scheduler runs, enter the critical section.
  *
  *  \param none
  */
 static void wizchip_critical_section_lock(void);
 
-/*! \brief Release a critical section
+/*! \brief Release the W5x00 bus
  *  \ingroup w5x00_spi
  *
- *  Set ciritical section exit function.
- *  Release a critical section.
+ *  Release the bus mutex or the critical section and record how long it was held.
  *
  *  \param none
  */
 static void wizchip_critical_section_unlock(void);
 
+/*! \brief Get the longest time the W5x00 lock masked interrupts
+ *  \ingroup w5x00_spi
+ *
+ *  Only the accesses before the scheduler starts mask interrupts.
+ *
+ *  \param none
+ *  \return longest masked time in us
+ */
+uint32_t wizchip_spi_get_max_masked_us(void);
+
+/*! \brief Get the longest time the W5x00 bus mutex was held
+ *  \ingroup w5x00_spi
+ *
+ *  \param none
+ *  \return longest bus hold time in us
+ */
+uint32_t wizchip_spi_get_max_bus_hold_us(void);
+
 /*! \brief Initialize SPI instances and Set DMA channel
  *  \ingroup w5x00_spi
  *
@@ -124,10 +286,52 @@ static void wizchip_critical_section_unlock(void);
  */
 void wizchip_spi_initialize(void);
 
+/*! \brief Calibrate the SPI clock
+ *  \ingroup w5x00_spi
+ *
+ *  Step the SPI clock up from the current rate to SPI_CLOCK_MAX_HZ and verify every step with
+ *  pattern writes and readbacks of a scratch register, scratch socket memory and VERSIONR.
+ *  Keep the fastest verified rate minus SPI_CLOCK_SAFETY_MARGIN_PERCENT.
+ *  The W5x00 is reset and initialized again when a step failed.
+ *  Print the chosen rate and the measured throughput.
+ *
+ *  \param none
+ *  \return the chosen SPI clock in Hz
+ */
+uint32_t wizchip_spi_calibrate(void);
+
+/*! \brief Get the number of SPI transactions
+ *  \ingroup w5x00_spi
+ *
+ *  Number of frames (header and data phase) sent to the W5x00 since startup.
+ *
+ *  \param none
+ *  \return transaction count
+ */
+uint32_t wizchip_spi_get_transaction_count(void);
+
+/*! \brief Get the SPI statistics
+ *  \ingroup w5x00_spi
+ *
+ *  Counters since startup or the last reset, split by register and socket buffer access.
+ *  They are updated under the W5x00 lock and copied without it, so the fields of a copy
+ *  can be a transaction apart. Compare two copies for rates.
+ *
+ *  \param stats the statistics
+ */
+void wizchip_spi_get_stats(wizchip_spi_stats_t *stats);
+
+/*! \brief Reset the SPI statistics
+ *  \ingroup w5x00_spi
+ *
+ *  \param none
+ */
+void wizchip_spi_reset_stats(void);
+
 /*! \brief Initialize a critical section structure
  *  \ingroup w5x00_spi
  *
- *  The critical section is initialized ready for use.
+ *  The critical section and the bus mutex are initialized ready for use.
  *  Registers callback function for critical section for WIZchip.
  *
  *  \param none
@@ -146,7 +350,7 @@ void wizchip_reset(void);
 /*! \brief Initialize WIZchip
  *  \ingroup w5x00_spi
  *
- *  Set callback function to read/write byte using SPI.
+ *  Set callback function to read/write byte and burst using SPI.
  *  Set callback function for WIZchip select/deselect.
  *  Set memory size of W5x00 chip and monitor PHY link status.
  *
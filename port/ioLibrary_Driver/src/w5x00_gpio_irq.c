@@ -32,24 +32,44 @@ static void (*callback_ptr)(void);
  */
 /* GPIO */
 void wizchip_gpio_interrupt_initialize(uint8_t socket, void (*callback)(void))
+{
+    wizchip_gpio_interrupt_initialize_mask(1 << socket, callback);
+}
+
+void wizchip_gpio_interrupt_initialize_mask(uint8_t socket_mask, void (*callback)(void))
 {
     uint16_t reg_val;
     int ret_val;
 
-    reg_val = (SIK_CONNECTED | SIK_DISCONNECTED | SIK_RECEIVED | SIK_TIMEOUT); // except SendOK
-    ret_val = ctlsocket(socket, CS_SET_INTMASK, (void *)&reg_val);
+    for (uint8_t socket = 0; socket < _WIZCHIP_SOCK_NUM_; socket++)
+    {
+        if (socket_mask & (1 << socket))
+        {
+            reg_val = (SIK_CONNECTED | SIK_DISCONNECTED | SIK_RECEIVED | SIK_TIMEOUT); // except SendOK
+            ret_val = ctlsocket(socket, CS_SET_INTMASK, (void *)&reg_val);
+        }
+    }
 
 #if (_WIZCHIP_ == W5100S)
-    reg_val = (1 << socket);
+    reg_val = socket_mask;
 #elif (_WIZCHIP_ == W5500)
-    reg_val = ((1 << socket) << 8);
+    reg_val = (socket_mask << 8);
 #endif
     ret_val = ctlwizchip(CW_SET_INTRMASK, (void *)&reg_val);
 
+    gpio_init(PIN_INT);
+    gpio_set_dir(PIN_INT, GPIO_IN);
+    gpio_pull_up(PIN_INT);
+
     callback_ptr = callback;
     gpio_set_irq_enabled_with_callback(PIN_INT, GPIO_IRQ_EDGE_FALL, true, &wizchip_gpio_interrupt_callback);
 }
 
+bool wizchip_gpio_interrupt_pending(void)
+{
+    return !gpio_get(PIN_INT);
+}
+
 static void wizchip_gpio_interrupt_callback(uint gpio, uint32_t events)
 {
     if (callback_ptr != NULL)
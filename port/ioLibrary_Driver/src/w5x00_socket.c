@@ -0,0 +1,323 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "wizchip_conf.h"
+#include "socket.h"
+#include "w5x00_socket.h"
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Sockets with a SEND command that is not acknowledged with SENDOK yet */
+static uint8_t g_socket_sending = 0;
+
+/* Most bytes waiting in the buffers since the last partitioning */
+static uint16_t g_socket_tx_peak[_WIZCHIP_SOCK_NUM_] = {0};
+static uint16_t g_socket_rx_peak[_WIZCHIP_SOCK_NUM_] = {0};
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+static uint16_t wizchip_socket_get16(const uint8_t *buf)
+{
+    return ((uint16_t)buf[0] << 8) | buf[1];
+}
+
+static void wizchip_socket_set_pointer(uint32_t addr, uint16_t pointer)
+{
+    uint8_t buf[2] = {(uint8_t)(pointer >> 8), (uint8_t)pointer};
+
+    WIZCHIP_WRITE_BUF(addr, buf, 2);
+}
+
+static void wizchip_socket_command(uint8_t sn, uint8_t command)
+{
+    setSn_CR(sn, command);
+
+    // wait to process the command
+    while (getSn_CR(sn))
+        ;
+}
+
+void wizchip_socket_snapshot(uint8_t sn, wizchip_socket_snapshot_t *snapshot)
+{
+    uint8_t regs[SOCKET_SNAPSHOT_SIZE];
+    uint8_t sizes[SOCKET_SNAPSHOT_SIZES_SIZE];
+
+    WIZCHIP_READ_BUF(Sn_MR(sn), regs, SOCKET_SNAPSHOT_SIZE);
+
+    // Sn_TX_FSR and Sn_RX_RSR can change between the two bytes, read until stable
+    for (int retry = 0; retry < SOCKET_SNAPSHOT_RETRY_COUNT; retry++)
+    {
+        WIZCHIP_READ_BUF(WIZCHIP_OFFSET_INC(Sn_MR(sn), SOCKET_SNAPSHOT_SIZES_OFFSET), sizes, SOCKET_SNAPSHOT_SIZES_SIZE);
+
+        uint8_t *previous = regs + SOCKET_SNAPSHOT_SIZES_OFFSET;
+        bool stable = (wizchip_socket_get16(previous + 0x00) == wizchip_socket_get16(sizes + 0x00)) &&
+                      (wizchip_socket_get16(previous + 0x06) == wizchip_socket_get16(sizes + 0x06));
+
+        for (int i = 0; i < SOCKET_SNAPSHOT_SIZES_SIZE; i++)
+        {
+            previous[i] = sizes[i];
+        }
+
+        if (stable)
+        {
+            break;
+        }
+    }
+
+    snapshot->mode = regs[0x00];
+    snapshot->status = regs[0x03];
+    snapshot->interrupt = regs[0x02] & 0x1F;
+    snapshot->tx_free_size = wizchip_socket_get16(regs + 0x20);
+    snapshot->tx_read_pointer = wizchip_socket_get16(regs + 0x22);
+    snapshot->tx_write_pointer = wizchip_socket_get16(regs + 0x24);
+    snapshot->rx_received_size = wizchip_socket_get16(regs + 0x26);
+    snapshot->rx_read_pointer = wizchip_socket_get16(regs + 0x28);
+    snapshot->rx_write_pointer = wizchip_socket_get16(regs + 0x2A);
+
+    if ((snapshot->status != SOCK_ESTABLISHED) && (snapshot->status != SOCK_CLOSE_WAIT))
+    {
+        g_socket_sending &= ~(1 << sn);
+    }
+
+    uint16_t tx_used = ((uint16_t)regs[SOCKET_SNAPSHOT_RXBUF_SIZE + 1] << 10) - snapshot->tx_free_size;
+
+    if (tx_used > g_socket_tx_peak[sn])
+    {
+        g_socket_tx_peak[sn] = tx_used;
+    }
+
+    if (snapshot->rx_received_size > g_socket_rx_peak[sn])
+    {
+        g_socket_rx_peak[sn] = snapshot->rx_received_size;
+    }
+}
+
+int32_t wizchip_socket_recv(uint8_t sn, wizchip_socket_snapshot_t *snapshot, uint8_t *buf, uint16_t len)
+{
+    if (len > snapshot->rx_received_size)
+    {
+        len = snapshot->rx_received_size;
+    }
+
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    wizchip_socket_peek(sn, snapshot, 0, buf, len);
+
+    return wizchip_socket_consume(sn, snapshot, len);
+}
+
+int32_t wizchip_socket_peek(uint8_t sn, const wizchip_socket_snapshot_t *snapshot, uint16_t offset, uint8_t *window, uint16_t len)
+{
+    if (offset >= snapshot->rx_received_size)
+    {
+        return 0;
+    }
+
+    if (len > snapshot->rx_received_size - offset)
+    {
+        len = snapshot->rx_received_size - offset;
+    }
+
+    // The chip wraps the offset inside the socket buffer
+    uint16_t pointer = snapshot->rx_read_pointer + offset;
+    WIZCHIP_READ_BUF(((uint32_t)pointer << 8) + (WIZCHIP_RXBUF_BLOCK(sn) << 3), window, len);
+
+    return len;
+}
+
+int32_t wizchip_socket_consume(uint8_t sn, wizchip_socket_snapshot_t *snapshot, uint16_t len)
+{
+    if (len > snapshot->rx_received_size)
+    {
+        len = snapshot->rx_received_size;
+    }
+
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    snapshot->rx_read_pointer += len;
+    snapshot->rx_received_size -= len;
+    wizchip_socket_set_pointer(Sn_RX_RD(sn), snapshot->rx_read_pointer);
+    wizchip_socket_command(sn, Sn_CR_RECV);
+
+    return len;
+}
+
+int32_t wizchip_socket_send_space(uint8_t sn, wizchip_socket_snapshot_t *snapshot)
+{
+    if (g_socket_sending & (1 << sn))
+    {
+        if (snapshot->interrupt & Sn_IR_TIMEOUT)
+        {
+            g_socket_sending &= ~(1 << sn);
+
+            return SOCKERR_TIMEOUT;
+        }
+
+        if (!(snapshot->interrupt & Sn_IR_SENDOK))
+        {
+            return SOCK_BUSY;
+        }
+
+        setSn_IR(sn, Sn_IR_SENDOK);
+        snapshot->interrupt &= ~Sn_IR_SENDOK;
+        g_socket_sending &= ~(1 << sn);
+    }
+
+    return snapshot->tx_free_size;
+}
+
+int32_t wizchip_socket_send_segments(uint8_t sn, wizchip_socket_snapshot_t *snapshot, const uint8_t *const *bufs, const uint16_t *lens, uint8_t count)
+{
+    int32_t space = wizchip_socket_send_space(sn, snapshot);
+    uint16_t len = 0;
+
+    if (space <= 0)
+    {
+        return space;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        len += lens[i];
+    }
+
+    if (len == 0 || len > space)
+    {
+        return SOCK_BUSY;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (lens[i] > 0)
+        {
+            WIZCHIP_WRITE_BUF(((uint32_t)snapshot->tx_write_pointer << 8) + (WIZCHIP_TXBUF_BLOCK(sn) << 3), (uint8_t *)bufs[i], lens[i]);
+            snapshot->tx_write_pointer += lens[i];
+        }
+    }
+
+    snapshot->tx_free_size -= len;
+    wizchip_socket_set_pointer(Sn_TX_WR(sn), snapshot->tx_write_pointer);
+    wizchip_socket_command(sn, Sn_CR_SEND);
+    g_socket_sending |= (1 << sn);
+
+    return len;
+}
+
+int32_t wizchip_socket_send(uint8_t sn, wizchip_socket_snapshot_t *snapshot, const uint8_t *buf, uint16_t len)
+{
+    return wizchip_socket_send_segments(sn, snapshot, &buf, &len, 1);
+}
+
+void wizchip_socket_reset(uint8_t sn)
+{
+    g_socket_sending &= ~(1 << sn);
+}
+
+static bool wizchip_socket_memory_idle(uint8_t sn)
+{
+    uint8_t status = getSn_SR(sn);
+
+    return (status == SOCK_CLOSED) || (status == SOCK_INIT) || (status == SOCK_LISTEN);
+}
+
+int8_t wizchip_socket_set_memory(const uint8_t *tx_kb, const uint8_t *rx_kb)
+{
+    uint8_t current[2];
+    uint16_t tx_total = 0;
+    uint16_t rx_total = 0;
+    uint16_t tx_base = 0;
+    uint16_t rx_base = 0;
+    uint16_t new_tx_base = 0;
+    uint16_t new_rx_base = 0;
+    uint8_t changed = 0;
+
+    for (int sn = 0; sn < _WIZCHIP_SOCK_NUM_; sn++)
+    {
+        // Power of two up to the total memory
+        if ((tx_kb[sn] & (tx_kb[sn] - 1)) || (rx_kb[sn] & (rx_kb[sn] - 1)) ||
+            (tx_kb[sn] > SOCKET_MEMORY_TOTAL_KB) || (rx_kb[sn] > SOCKET_MEMORY_TOTAL_KB))
+        {
+            return SOCKET_MEMORY_INVALID;
+        }
+
+        tx_total += tx_kb[sn];
+        rx_total += rx_kb[sn];
+    }
+
+    if ((tx_total > SOCKET_MEMORY_TOTAL_KB) || (rx_total > SOCKET_MEMORY_TOTAL_KB))
+    {
+        return SOCKET_MEMORY_INVALID;
+    }
+
+    // A socket keeps working when its buffer stays where it is
+    for (int sn = 0; sn < _WIZCHIP_SOCK_NUM_; sn++)
+    {
+        WIZCHIP_READ_BUF(Sn_RXBUF_SIZE(sn), current, 2);
+
+        if ((rx_base != new_rx_base) || (current[0] != rx_kb[sn]) ||
+            (tx_base != new_tx_base) || (current[1] != tx_kb[sn]))
+        {
+            if (!wizchip_socket_memory_idle(sn))
+            {
+                return SOCKET_MEMORY_BUSY;
+            }
+
+            changed |= (1 << sn);
+        }
+
+        rx_base += current[0];
+        tx_base += current[1];
+        new_rx_base += rx_kb[sn];
+        new_tx_base += tx_kb[sn];
+    }
+
+    for (int sn = 0; sn < _WIZCHIP_SOCK_NUM_; sn++)
+    {
+        if (changed & (1 << sn))
+        {
+            uint8_t sizes[2] = {rx_kb[sn], tx_kb[sn]};
+
+            WIZCHIP_WRITE_BUF(Sn_RXBUF_SIZE(sn), sizes, 2);
+        }
+
+        g_socket_tx_peak[sn] = 0;
+        g_socket_rx_peak[sn] = 0;
+    }
+
+    return SOCKET_MEMORY_OK;
+}
+
+void wizchip_socket_get_memory_stats(uint8_t sn, wizchip_socket_memory_stats_t *stats)
+{
+    uint8_t sizes[2];
+
+    WIZCHIP_READ_BUF(Sn_RXBUF_SIZE(sn), sizes, 2);
+
+    stats->rx_kb = sizes[0];
+    stats->tx_kb = sizes[1];
+    stats->tx_peak = g_socket_tx_peak[sn];
+    stats->rx_peak = g_socket_rx_peak[sn];
+}
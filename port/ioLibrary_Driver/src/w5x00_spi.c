@@ -10,7 +10,10 @@
  * ----------------------------------------------------------------------------------------------------
  */
 #include <stdio.h>
+#include <string.h>
 #include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
 
 #include "port_common.h"
 
@@ -23,12 +26,35 @@
  * ----------------------------------------------------------------------------------------------------
  */
 static critical_section_t g_wizchip_cri_sec;
+static SemaphoreHandle_t g_wizchip_bus_mutex = NULL;
+static bool g_wizchip_bus_mutex_taken = false;
+static uint32_t g_wizchip_lock_start_us = 0;
+static uint32_t g_wizchip_max_bus_hold_us = 0;
+static uint32_t g_wizchip_max_masked_us = 0;
+
+static uint8_t g_frame_header[SPI_FRAME_HEADER_SIZE];
+static uint8_t g_frame_header_len = 0;
+static bool g_frame_collect_header = false;
+static volatile uint32_t g_frame_count = 0;
+static uint8_t g_frame_class = SPI_STATS_CLASS_REGISTER;
+static bool g_frame_write = false;
+static uint32_t g_frame_start_us = 0;
+static bool g_frame_selected = false;
+
+static wizchip_spi_stats_t g_spi_stats = {0};
 
 #ifdef USE_SPI_DMA
 static uint dma_tx;
 static uint dma_rx;
+static uint dma_tx_header;
+static uint dma_rx_header;
 static dma_channel_config dma_channel_config_tx;
 static dma_channel_config dma_channel_config_rx;
+static dma_channel_config dma_channel_config_tx_header;
+static dma_channel_config dma_channel_config_rx_header;
+
+static volatile TaskHandle_t g_dma_waiting_task = NULL;
+static uint16_t g_dma_async_min_len = SPI_DMA_ASYNC_MIN_LEN;
 #endif
 
 /**
@@ -39,11 +65,36 @@ static dma_channel_config dma_channel_config_rx;
 static inline void wizchip_select(void)
 {
     gpio_put(PIN_CS, 0);
+
+    // The next SPI_FRAME_HEADER_SIZE bytes written are the address and control phase,
+    // they are held back and sent together with the data phase.
+    g_frame_header_len = 0;
+    g_frame_collect_header = true;
+    g_frame_start_us = time_us_32();
+    g_frame_selected = true;
 }
 
 static inline void wizchip_deselect(void)
 {
+    if (g_frame_header_len > 0)
+    {
+        // Header without data phase, should not happen but never drop bytes
+        wizchip_frame_transfer(NULL, NULL, 0);
+    }
+    g_frame_collect_header = false;
+
     gpio_put(PIN_CS, 1);
+
+    if (g_frame_selected)
+    {
+        uint32_t frame_us = time_us_32() - g_frame_start_us;
+
+        if (frame_us > g_spi_stats.classes[g_frame_class].max_transaction_us)
+        {
+            g_spi_stats.classes[g_frame_class].max_transaction_us = frame_us;
+        }
+        g_frame_selected = false;
+    }
 }
 
 void wizchip_reset()
@@ -60,87 +111,332 @@ void wizchip_reset()
     bi_decl(bi_1pin_with_name(PIN_RST, "W5x00 RESET"));
 }
 
-static uint8_t wizchip_read(void)
+static void wizchip_frame_transfer_fifo(const uint8_t *tx_data, uint8_t *rx_data, uint16_t len)
 {
-    uint8_t rx_data = 0;
-    uint8_t tx_data = 0xFF;
+    spi_hw_t *spi_hw = spi_get_hw(SPI_PORT);
+    uint32_t total = g_frame_header_len + len;
+    uint32_t tx_index = 0;
+    uint32_t rx_index = 0;
+
+    // Keep the TX FIFO filled from header and data without a gap between the phases,
+    // never more than the FIFO depth ahead of the RX side to avoid an RX overrun.
+    while ((tx_index < total) || (rx_index < total))
+    {
+        if ((tx_index < total) && spi_is_writable(SPI_PORT) && (tx_index < rx_index + SPI_FIFO_DEPTH))
+        {
+            uint8_t tx_byte;
+
+            if (tx_index < g_frame_header_len)
+            {
+                tx_byte = g_frame_header[tx_index];
+            }
+            else
+            {
+                tx_byte = tx_data ? tx_data[tx_index - g_frame_header_len] : 0xFF;
+            }
+            spi_hw->dr = tx_byte;
+            tx_index++;
+        }
 
-    spi_read_blocking(SPI_PORT, tx_data, &rx_data, 1);
+        if ((rx_index < total) && spi_is_readable(SPI_PORT))
+        {
+            uint8_t rx_byte = (uint8_t)spi_hw->dr;
 
-    return rx_data;
+            if (rx_data && (rx_index >= g_frame_header_len))
+            {
+                rx_data[rx_index - g_frame_header_len] = rx_byte;
+            }
+            rx_index++;
+        }
+    }
 }
 
-static void wizchip_write(uint8_t tx_data)
+#ifdef USE_SPI_DMA
+static void wizchip_dma_irq_handler(void)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if (dma_channel_get_irq0_status(dma_rx))
+    {
+        dma_channel_acknowledge_irq0(dma_rx);
+        dma_channel_set_irq0_enabled(dma_rx, false);
+
+        if (g_dma_waiting_task != NULL)
+        {
+            vTaskNotifyGiveIndexedFromISR(g_dma_waiting_task, SPI_DMA_NOTIFY_INDEX, &higher_priority_task_woken);
+            g_dma_waiting_task = NULL;
+        }
+    }
+
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+static void wizchip_dma_wait_for_finish(void)
 {
-    spi_write_blocking(SPI_PORT, &tx_data, 1);
+    // With a header the start mask holds only the header channels, the data channels are not busy
+    // until the header chains into them: wait for the header first, or CS rises in the middle of the frame
+    if (g_frame_header_len > 0)
+    {
+        dma_channel_wait_for_finish_blocking(dma_rx_header);
+    }
+    dma_channel_wait_for_finish_blocking(dma_rx);
 }
 
-#ifdef USE_SPI_DMA
-static void wizchip_read_burst(uint8_t *pBuf, uint16_t len)
+static void wizchip_dma_transfer(uint32_t start_mask, uint16_t len)
 {
-    uint8_t dummy_data = 0xFF;
+    if ((len < g_dma_async_min_len) || !g_wizchip_bus_mutex_taken)
+    {
+        // Short transfer (or scheduler not running): a context switch costs more than the transfer itself
+        dma_start_channel_mask(start_mask);
+        wizchip_dma_wait_for_finish();
+        return;
+    }
 
-    channel_config_set_read_increment(&dma_channel_config_tx, false);
-    channel_config_set_write_increment(&dma_channel_config_tx, false);
-    dma_channel_configure(dma_tx, &dma_channel_config_tx,
-                          &spi_get_hw(SPI_PORT)->dr, // write address
-                          &dummy_data,               // read address
-                          len,                       // element count (each element is of size transfer_data_size)
-                          false);                    // don't start yet
+    // The bus mutex keeps other tasks away from the chip while this task sleeps,
+    // the completion interrupt wakes us up again.
+    (void)ulTaskNotifyTakeIndexed(SPI_DMA_NOTIFY_INDEX, pdTRUE, 0);
+    g_dma_waiting_task = xTaskGetCurrentTaskHandle();
+    dma_channel_acknowledge_irq0(dma_rx);
+    dma_channel_set_irq0_enabled(dma_rx, true);
 
-    channel_config_set_read_increment(&dma_channel_config_rx, false);
-    channel_config_set_write_increment(&dma_channel_config_rx, true);
-    dma_channel_configure(dma_rx, &dma_channel_config_rx,
-                          pBuf,                      // write address
-                          &spi_get_hw(SPI_PORT)->dr, // read address
-                          len,                       // element count (each element is of size transfer_data_size)
-                          false);                    // don't start yet
+    dma_start_channel_mask(start_mask);
 
-    dma_start_channel_mask((1u << dma_tx) | (1u << dma_rx));
-    dma_channel_wait_for_finish_blocking(dma_rx);
+    if (ulTaskNotifyTakeIndexed(SPI_DMA_NOTIFY_INDEX, pdTRUE, pdMS_TO_TICKS(SPI_DMA_TIMEOUT_MS)) == 0)
+    {
+        printf(" SPI DMA completion interrupt timeout\n");
+        wizchip_dma_wait_for_finish();
+    }
+
+    dma_channel_set_irq0_enabled(dma_rx, false);
+    g_dma_waiting_task = NULL;
 }
 
-static void wizchip_write_burst(uint8_t *pBuf, uint16_t len)
+static void wizchip_frame_transfer_dma(const uint8_t *tx_data, uint8_t *rx_data, uint16_t len)
 {
-    uint8_t dummy_data;
+    static uint8_t dummy_tx = 0xFF;
+    static uint8_t dummy_rx;
+    uint32_t start_mask = (1u << dma_tx) | (1u << dma_rx);
 
-    channel_config_set_read_increment(&dma_channel_config_tx, true);
+    channel_config_set_read_increment(&dma_channel_config_tx, tx_data != NULL);
     channel_config_set_write_increment(&dma_channel_config_tx, false);
     dma_channel_configure(dma_tx, &dma_channel_config_tx,
-                          &spi_get_hw(SPI_PORT)->dr, // write address
-                          pBuf,                      // read address
-                          len,                       // element count (each element is of size transfer_data_size)
-                          false);                    // don't start yet
+                          &spi_get_hw(SPI_PORT)->dr,      // write address
+                          tx_data ? tx_data : &dummy_tx,  // read address
+                          len,                            // element count (each element is of size transfer_data_size)
+                          false);                         // don't start yet
 
     channel_config_set_read_increment(&dma_channel_config_rx, false);
-    channel_config_set_write_increment(&dma_channel_config_rx, false);
+    channel_config_set_write_increment(&dma_channel_config_rx, rx_data != NULL);
     dma_channel_configure(dma_rx, &dma_channel_config_rx,
-                          &dummy_data,               // write address
-                          &spi_get_hw(SPI_PORT)->dr, // read address
-                          len,                       // element count (each element is of size transfer_data_size)
-                          false);                    // don't start yet
+                          rx_data ? rx_data : &dummy_rx,  // write address
+                          &spi_get_hw(SPI_PORT)->dr,      // read address
+                          len,                            // element count (each element is of size transfer_data_size)
+                          false);                         // don't start yet
 
-    dma_start_channel_mask((1u << dma_tx) | (1u << dma_rx));
-    dma_channel_wait_for_finish_blocking(dma_rx);
+    if (g_frame_header_len > 0)
+    {
+        // Header channels run first and chain into the data channels, one uninterrupted frame
+        dma_channel_configure(dma_tx_header, &dma_channel_config_tx_header,
+                              &spi_get_hw(SPI_PORT)->dr,
+                              g_frame_header,
+                              g_frame_header_len,
+                              false);
+        dma_channel_configure(dma_rx_header, &dma_channel_config_rx_header,
+                              &dummy_rx,
+                              &spi_get_hw(SPI_PORT)->dr,
+                              g_frame_header_len,
+                              false);
+        start_mask = (1u << dma_tx_header) | (1u << dma_rx_header);
+    }
+
+    wizchip_dma_transfer(start_mask, len);
+}
+
+void wizchip_spi_set_dma_async_min_len(uint16_t len)
+{
+    g_dma_async_min_len = len;
 }
 #endif
 
+static void wizchip_frame_transfer(const uint8_t *tx_data, uint8_t *rx_data, uint16_t len)
+{
+    wizchip_spi_class_stats_t *class_stats;
+
+    if (g_frame_header_len == SPI_FRAME_HEADER_SIZE)
+    {
+        // Control byte: block select in bits 7..3, 0 common registers, then 4 blocks per socket
+        // (registers, TX buffer, RX buffer), read/write in bit 2
+        uint8_t block = g_frame_header[2] >> 3;
+
+        g_frame_class = ((block & 0x03) >= 0x02) ? SPI_STATS_CLASS_BUFFER : SPI_STATS_CLASS_REGISTER;
+        g_frame_write = (g_frame_header[2] & 0x04) != 0;
+        g_spi_stats.classes[g_frame_class].transactions++;
+    }
+
+    class_stats = &g_spi_stats.classes[g_frame_class];
+    class_stats->bytes_written += g_frame_header_len;
+
+    if (g_frame_write)
+    {
+        class_stats->bytes_written += len;
+    }
+    else
+    {
+        class_stats->bytes_read += len;
+    }
+
+#ifdef USE_SPI_DMA
+    if (len >= SPI_FRAME_DMA_MIN_LEN)
+    {
+        wizchip_frame_transfer_dma(tx_data, rx_data, len);
+    }
+    else
+#endif
+    {
+        wizchip_frame_transfer_fifo(tx_data, rx_data, len);
+    }
+
+    g_frame_header_len = 0;
+    g_frame_collect_header = false;
+    g_frame_count++;
+}
+
+uint32_t wizchip_spi_get_transaction_count(void)
+{
+    return g_frame_count;
+}
+
+void wizchip_spi_get_stats(wizchip_spi_stats_t *stats)
+{
+    memcpy(stats, &g_spi_stats, sizeof(wizchip_spi_stats_t));
+}
+
+void wizchip_spi_reset_stats(void)
+{
+    memset(&g_spi_stats, 0, sizeof(wizchip_spi_stats_t));
+}
+
+static uint16_t wizchip_frame_collect_header(const uint8_t *tx_data, uint16_t len)
+{
+    uint16_t used = 0;
+
+    while (g_frame_collect_header && (used < len))
+    {
+        g_frame_header[g_frame_header_len++] = tx_data[used++];
+
+        if (g_frame_header_len == SPI_FRAME_HEADER_SIZE)
+        {
+            g_frame_collect_header = false;
+        }
+    }
+
+    return used;
+}
+
+static uint8_t wizchip_read(void)
+{
+    uint8_t rx_data = 0;
+
+    g_spi_stats.single_calls++;
+
+    wizchip_frame_transfer(NULL, &rx_data, 1);
+
+    return rx_data;
+}
+
+static void wizchip_write(uint8_t tx_data)
+{
+    g_spi_stats.single_calls++;
+
+    if (wizchip_frame_collect_header(&tx_data, 1) == 0)
+    {
+        wizchip_frame_transfer(&tx_data, NULL, 1);
+    }
+}
+
+static void wizchip_read_burst(uint8_t *pBuf, uint16_t len)
+{
+    g_spi_stats.burst_calls++;
+
+    wizchip_frame_transfer(NULL, pBuf, len);
+}
+
+static void wizchip_write_burst(uint8_t *pBuf, uint16_t len)
+{
+    g_spi_stats.burst_calls++;
+
+    uint16_t used = wizchip_frame_collect_header(pBuf, len);
+
+    if (used < len)
+    {
+        wizchip_frame_transfer(pBuf + used, NULL, len - used);
+    }
+}
+
 static void wizchip_critical_section_lock(void)
 {
-    critical_section_enter_blocking(&g_wizchip_cri_sec);
-    vPortEnterCritical();
+    if ((get_core_num() == 0) && (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING))
+    {
+        // Bus ownership only: interrupts, the tick and tasks that do not use the chip keep running.
+        // A lower priority owner inherits the priority of a waiting dhcp_task until it releases the bus.
+        xSemaphoreTake(g_wizchip_bus_mutex, portMAX_DELAY);
+        g_wizchip_bus_mutex_taken = true;
+    }
+    else
+    {
+        // A mutex cannot be taken before the scheduler runs, only the startup code uses the chip then.
+        // Core 1 runs outside FreeRTOS, when it owns the chip core 0 does not use it.
+        critical_section_enter_blocking(&g_wizchip_cri_sec);
+    }
+
+    g_wizchip_lock_start_us = time_us_32();
 }
 
 static void wizchip_critical_section_unlock(void)
 {
-    critical_section_exit(&g_wizchip_cri_sec);
-    vPortExitCritical();
+    uint32_t held_us = time_us_32() - g_wizchip_lock_start_us;
+
+    g_spi_stats.locked_us += held_us;
+    if (held_us > g_spi_stats.max_locked_us)
+    {
+        g_spi_stats.max_locked_us = held_us;
+    }
+
+    if (g_wizchip_bus_mutex_taken)
+    {
+        if (held_us > g_wizchip_max_bus_hold_us)
+        {
+            g_wizchip_max_bus_hold_us = held_us;
+        }
+
+        g_wizchip_bus_mutex_taken = false;
+        xSemaphoreGive(g_wizchip_bus_mutex);
+    }
+    else
+    {
+        if (held_us > g_wizchip_max_masked_us)
+        {
+            g_wizchip_max_masked_us = held_us;
+        }
+
+        critical_section_exit(&g_wizchip_cri_sec);
+    }
+}
+
+uint32_t wizchip_spi_get_max_masked_us(void)
+{
+    return g_wizchip_max_masked_us;
+}
+
+uint32_t wizchip_spi_get_max_bus_hold_us(void)
+{
+    return g_wizchip_max_bus_hold_us;
 }
 
 void wizchip_spi_initialize(void)
 {
-    // this example will use SPI0 at 5MHz
-    spi_init(SPI_PORT, 5000 * 1000);
+    // start at a safe clock, wizchip_spi_calibrate can raise it once the chip is up
+    spi_init(SPI_PORT, SPI_CLOCK_DEFAULT_HZ);
 
     gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
     gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
@@ -173,12 +469,35 @@ void wizchip_spi_initialize(void)
     channel_config_set_dreq(&dma_channel_config_rx, DREQ_SPI0_RX);
     channel_config_set_read_increment(&dma_channel_config_rx, false);
     channel_config_set_write_increment(&dma_channel_config_rx, true);
+
+    // The header channels send the address and control phase and then trigger the data channels
+    dma_tx_header = dma_claim_unused_channel(true);
+    dma_rx_header = dma_claim_unused_channel(true);
+
+    dma_channel_config_tx_header = dma_channel_get_default_config(dma_tx_header);
+    channel_config_set_transfer_data_size(&dma_channel_config_tx_header, DMA_SIZE_8);
+    channel_config_set_dreq(&dma_channel_config_tx_header, DREQ_SPI0_TX);
+    channel_config_set_read_increment(&dma_channel_config_tx_header, true);
+    channel_config_set_write_increment(&dma_channel_config_tx_header, false);
+    channel_config_set_chain_to(&dma_channel_config_tx_header, dma_tx);
+
+    dma_channel_config_rx_header = dma_channel_get_default_config(dma_rx_header);
+    channel_config_set_transfer_data_size(&dma_channel_config_rx_header, DMA_SIZE_8);
+    channel_config_set_dreq(&dma_channel_config_rx_header, DREQ_SPI0_RX);
+    channel_config_set_read_increment(&dma_channel_config_rx_header, false);
+    channel_config_set_write_increment(&dma_channel_config_rx_header, false);
+    channel_config_set_chain_to(&dma_channel_config_rx_header, dma_rx);
+
+    // Completion of the RX channel wakes up the task waiting for a long burst
+    irq_add_shared_handler(DMA_IRQ_0, wizchip_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
 #endif
 }
 
 void wizchip_cris_initialize(void)
 {
     critical_section_init(&g_wizchip_cri_sec);
+    g_wizchip_bus_mutex = xSemaphoreCreateMutex();
     reg_wizchip_cris_cbfunc(wizchip_critical_section_lock, wizchip_critical_section_unlock);
 }
 
@@ -192,9 +511,7 @@ void wizchip_initialize(void)
 
     /* SPI function register */
     reg_wizchip_spi_cbfunc(wizchip_read, wizchip_write);
-#ifdef USE_SPI_DMA
     reg_wizchip_spiburst_cbfunc(wizchip_read_burst, wizchip_write_burst);
-#endif
 
     /* W5x00 initialize */
     uint8_t temp;
@@ -246,6 +563,132 @@ void wizchip_check(void)
 #endif
 }
 
+/* SPI clock calibration, the version and scratch registers are those of the W5500 */
+#if (_WIZCHIP_ == W5500)
+static bool wizchip_spi_verify_link(void)
+{
+    static const uint8_t patterns[] = {0x00, 0xFF, 0x55, 0xAA, 0x01, 0x80, 0x5A, 0xA5};
+    uint8_t tx_buf[SPI_CALIBRATION_BURST_SIZE];
+    uint8_t rx_buf[SPI_CALIBRATION_BURST_SIZE];
+    uint32_t seed = time_us_32();
+
+    for (int round = 0; round < SPI_CALIBRATION_ROUNDS; round++)
+    {
+        if (getVERSIONR() != 0x04)
+        {
+            return false;
+        }
+
+        // Single byte accesses to a scratch register
+        for (int i = 0; i < sizeof(patterns); i++)
+        {
+            WIZCHIP_WRITE(SPI_CALIBRATION_SCRATCH_REG, patterns[i]);
+            if (WIZCHIP_READ(SPI_CALIBRATION_SCRATCH_REG) != patterns[i])
+            {
+                return false;
+            }
+        }
+
+        // Burst access to the TX memory of the scratch socket
+        for (int i = 0; i < SPI_CALIBRATION_BURST_SIZE; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            tx_buf[i] = (uint8_t)(seed >> 16);
+        }
+        WIZCHIP_WRITE_BUF(SPI_CALIBRATION_SCRATCH_MEM, tx_buf, SPI_CALIBRATION_BURST_SIZE);
+        WIZCHIP_READ_BUF(SPI_CALIBRATION_SCRATCH_MEM, rx_buf, SPI_CALIBRATION_BURST_SIZE);
+        if (memcmp(tx_buf, rx_buf, SPI_CALIBRATION_BURST_SIZE) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static uint32_t wizchip_spi_measure_throughput(void)
+{
+    static uint8_t buf[SPI_MEASURE_SIZE];
+    uint64_t start = time_us_64();
+
+    WIZCHIP_WRITE_BUF(SPI_CALIBRATION_SCRATCH_MEM, buf, SPI_MEASURE_SIZE);
+    WIZCHIP_READ_BUF(SPI_CALIBRATION_SCRATCH_MEM, buf, SPI_MEASURE_SIZE);
+
+    uint64_t elapsed_us = time_us_64() - start;
+
+    return elapsed_us ? (uint32_t)(((uint64_t)2 * SPI_MEASURE_SIZE * 1000 * 1000) / elapsed_us) : 0;
+}
+#endif
+
+uint32_t wizchip_spi_calibrate(void)
+{
+    uint32_t peri_hz = clock_get_hz(clk_peri);
+    uint32_t best_hz = spi_get_baudrate(SPI_PORT);
+
+#if defined(SPI_CLOCK_CALIBRATE) && (_WIZCHIP_ == W5500)
+    uint32_t previous_hz = 0;
+    bool link_failed = false;
+
+    // The SPI clock is clk_peri divided by an even prescaler and a postdivider,
+    // stepping the total divider down walks through every reachable rate.
+    for (uint32_t divider = peri_hz / best_hz; divider >= 2; divider--)
+    {
+        uint32_t target_hz = peri_hz / divider;
+
+        if (target_hz > SPI_CLOCK_MAX_HZ)
+        {
+            break;
+        }
+
+        uint32_t actual_hz = spi_set_baudrate(SPI_PORT, target_hz);
+        if (actual_hz == previous_hz)
+        {
+            continue;
+        }
+        previous_hz = actual_hz;
+
+        if (!wizchip_spi_verify_link())
+        {
+            printf(" SPI clock %ld Hz failed verification\n", actual_hz);
+            link_failed = true;
+            break;
+        }
+
+        best_hz = actual_hz;
+    }
+
+    // Back off from the fastest verified rate to cover temperature and supply drift
+    best_hz = spi_set_baudrate(SPI_PORT, (best_hz / 100) * (100 - SPI_CLOCK_SAFETY_MARGIN_PERCENT));
+
+    if (!wizchip_spi_verify_link())
+    {
+        printf(" SPI clock %ld Hz failed verification, falling back to %d Hz\n", best_hz, SPI_CLOCK_DEFAULT_HZ);
+        best_hz = spi_set_baudrate(SPI_PORT, SPI_CLOCK_DEFAULT_HZ);
+        link_failed = true;
+    }
+
+    WIZCHIP_WRITE(SPI_CALIBRATION_SCRATCH_REG, 0x00);
+
+    if (link_failed)
+    {
+        // A corrupted address phase may have written anywhere in the chip, start clean
+        wizchip_reset();
+        wizchip_initialize();
+        wizchip_check();
+    }
+#elif defined(SPI_CLOCK_CALIBRATE)
+    printf(" SPI clock calibration needs a W5500, keeping %ld Hz\n", best_hz);
+#endif
+
+#if (_WIZCHIP_ == W5100S)
+    printf(" SPI clock : %ld Hz (clk_peri %ld Hz)\n", best_hz, peri_hz);
+#elif (_WIZCHIP_ == W5500)
+    printf(" SPI clock : %ld Hz (clk_peri %ld Hz), measured %ld bytes/s\n", best_hz, peri_hz, wizchip_spi_measure_throughput());
+#endif
+
+    return best_hz;
+}
+
 /* Network */
 void network_initialize(wiz_NetInfo net_info)
 {
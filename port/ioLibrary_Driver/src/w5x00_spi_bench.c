@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2022 WIZnet Co.,Ltd
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Includes
+ * ----------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "port_common.h"
+
+#include "wizchip_conf.h"
+#include "w5x00_spi.h"
+
+#if defined(USE_SPI_DMA) && defined(USE_SPI_DMA_BENCHMARK)
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Macros
+ * ----------------------------------------------------------------------------------------------------
+ */
+/* Benchmark */
+#define BENCH_SOCKET 7
+#define BENCH_BURST_SIZE (1024 * 2)
+#define BENCH_ITERATIONS 100
+#define BENCH_BACKGROUND_STACK_SIZE 256
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Variables
+ * ----------------------------------------------------------------------------------------------------
+ */
+static volatile uint32_t g_background_count = 0;
+static uint8_t g_bench_buf[BENCH_BURST_SIZE];
+
+/**
+ * ----------------------------------------------------------------------------------------------------
+ * Functions
+ * ----------------------------------------------------------------------------------------------------
+ */
+static void wizchip_dma_benchmark_background_task(void *argument)
+{
+    while (1)
+    {
+        g_background_count++;
+    }
+}
+
+static void wizchip_dma_benchmark_run(const char *name, uint16_t async_min_len, uint32_t idle_count_per_ms)
+{
+    // Read the complete RX buffer of an unused socket, the content does not matter
+    uint32_t addr = (WIZCHIP_RXBUF_BLOCK(BENCH_SOCKET) << 3);
+
+    wizchip_spi_set_dma_async_min_len(async_min_len);
+
+    uint32_t start_count = g_background_count;
+    uint64_t start_time = time_us_64();
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        WIZCHIP_READ_BUF(addr, g_bench_buf, BENCH_BURST_SIZE);
+    }
+
+    uint64_t elapsed_us = time_us_64() - start_time;
+    uint32_t background = g_background_count - start_count;
+    uint32_t available = (uint32_t)((idle_count_per_ms * elapsed_us) / 1000);
+
+    printf(" %-8s: %d x %d bytes in %lld us (%lld bytes/s), background task got %ld%% of the CPU\n",
+           name, BENCH_ITERATIONS, BENCH_BURST_SIZE, elapsed_us,
+           ((uint64_t)BENCH_ITERATIONS * BENCH_BURST_SIZE * 1000 * 1000) / elapsed_us,
+           available ? (background * 100) / available : 0);
+}
+
+void wizchip_dma_benchmark_task(void *argument)
+{
+    TaskHandle_t background_task;
+
+    xTaskCreate(wizchip_dma_benchmark_background_task, "Bench_BG_Task", BENCH_BACKGROUND_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, &background_task);
+
+    // Reference: how fast does the background task count when it has the CPU for itself
+    uint32_t start_count = g_background_count;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    uint32_t idle_count_per_ms = (g_background_count - start_count) / 100;
+
+    printf("SPI DMA benchmark, socket %d RX buffer\n", BENCH_SOCKET);
+    wizchip_dma_benchmark_run("polled", 0xFFFF, idle_count_per_ms);
+    wizchip_dma_benchmark_run("irq", SPI_DMA_ASYNC_MIN_LEN, idle_count_per_ms);
+
+    vTaskDelete(background_task);
+    vTaskDelete(NULL);
+}
+#endif
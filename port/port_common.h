@@ -18,6 +18,7 @@
 #include "pico/critical_section.h"
 #include "hardware/spi.h"
 #include "hardware/dma.h"
+#include "hardware/irq.h"
 #include "hardware/clocks.h"
 
 #endif /* _PORT_COMMON_H_ */
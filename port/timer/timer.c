@@ -24,6 +24,10 @@
 static struct repeating_timer g_timer;
 void (*callback_ptr)(void);
 
+/* Interrupt latency */
+static uint32_t g_last_callback_us = 0;
+static uint32_t g_max_latency_us = 0;
+
 /**
  * ----------------------------------------------------------------------------------------------------
  * Functions
@@ -38,10 +42,31 @@ void wizchip_1ms_timer_initialize(void (*callback)(void))
 
 bool wizchip_1ms_timer_callback(struct repeating_timer *t)
 {
+    // A callback later than 1 ms after the previous one was held off by masked interrupts
+    uint32_t now = time_us_32();
+
+    if (g_last_callback_us != 0)
+    {
+        uint32_t interval = now - g_last_callback_us;
+
+        if ((interval > 1000) && (interval - 1000 > g_max_latency_us))
+        {
+            g_max_latency_us = interval - 1000;
+        }
+    }
+    g_last_callback_us = now;
+
     if (callback_ptr != NULL)
     {
         callback_ptr();
     }
+
+    return true;
+}
+
+uint32_t wizchip_1ms_timer_get_max_latency_us(void)
+{
+    return g_max_latency_us;
 }
 
 /* Delay */
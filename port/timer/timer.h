@@ -39,6 +39,17 @@ void wizchip_1ms_timer_initialize(void (*callback)(void));
  */
 bool wizchip_1ms_timer_callback(struct repeating_timer *t);
 
+/*! \brief Get the worst 1ms timer latency
+ *  \ingroup timer
+ *
+ *  Longest delay of the 1ms timer callback beyond its period, an upper bound
+ *  of the time interrupts stayed masked anywhere in the system.
+ *
+ *  \param none
+ *  \return worst latency in us
+ */
+uint32_t wizchip_1ms_timer_get_max_latency_us(void);
+
 /* Delay */
 /*! \brief Wait for the given number of milliseconds before returning
  *  \ingroup timer
@@ -0,0 +1,185 @@
+#include "command.h"
+
+#include <string.h>
+#include "types.h"
+
+#define COMMAND(name, message_type, value) { name, sizeof(name) - 1, message_type, value, false }
+#define COMMAND_ARGUMENT(name, message_type) { name, sizeof(name) - 1, message_type, 0, true }
+
+static const command_t commands[] =
+{
+    COMMAND("GET",  MSG_GET_STATUS, 0),
+    COMMAND("SET0", MSG_SET_SPEED,  0),
+    COMMAND("SET1", MSG_SET_SPEED,  1),
+    COMMAND("SET2", MSG_SET_SPEED,  2),
+    COMMAND("SET3", MSG_SET_SPEED,  3),
+    COMMAND("HB",   MSG_KEEPALIVE,  0),
+    COMMAND("SPI",  MSG_SPI_STATS,  0),
+    COMMAND("BIN",  MSG_BINARY,     0),
+    COMMAND("SUB",  MSG_SUBSCRIBE,  1),
+    COMMAND("UNSUB", MSG_SUBSCRIBE, 0),
+    COMMAND("LAT",  MSG_LATENCY,    0),
+    COMMAND("REM",  MSG_REMAINING_TIME, 0),
+    COMMAND_ARGUMENT("PRG", MSG_PROGRAM),           // PRG<speed>,<minutes>#
+    COMMAND("PRGOFF", MSG_PROGRAM,  0),
+    COMMAND_ARGUMENT("SCH", MSG_SCHEDULE),          // SCH<hhmm>,<speed>#, every day
+    COMMAND("SCHOFF", MSG_SCHEDULE, -1),
+    COMMAND_ARGUMENT("CLK", MSG_CLOCK),             // CLK<hhmmss>#, time of day for the schedule
+    COMMAND_ARGUMENT("TPUSH", MSG_PUSH_INTERVAL),   // TPUSH<seconds>#, remaining time push while a program runs
+    COMMAND_ARGUMENT("MEM", MSG_MEMORY_PROFILE),    // MEM<profile>#, socket memory profile of the W5x00, MEMQ<profile># when it is queued
+};
+
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+//Slot of each command in the hash index, 0 is a free slot
+static uint8_t command_index[COMMAND_HASH_SIZE];
+
+static uint32_t command_hash(const uint8_t* text, uint16_t length)
+{
+    uint32_t hash = length;
+
+    while (length--)
+    {
+        hash = hash * 31 + *text++;
+    }
+
+    return hash;
+}
+
+void command_initialize(void)
+{
+    memset(command_index, 0, sizeof(command_index));
+
+    for (uint8_t i = 0; i < COMMAND_COUNT; i++)
+    {
+        uint32_t slot = command_hash((const uint8_t*)commands[i].name, commands[i].length);
+
+        //Linear probing, the index is never full
+        while (command_index[slot & (COMMAND_HASH_SIZE - 1)] != 0)
+        {
+            slot++;
+        }
+        command_index[slot & (COMMAND_HASH_SIZE - 1)] = i + 1;
+    }
+}
+
+const command_t* command_lookup(const uint8_t* text, uint16_t length)
+{
+    uint32_t slot = command_hash(text, length);
+    uint8_t index;
+
+    while ((index = command_index[slot & (COMMAND_HASH_SIZE - 1)]) != 0)
+    {
+        const command_t* command = &commands[index - 1];
+
+        if (command->length == length && !memcmp(command->name, text, length))
+        {
+            return command;
+        }
+        slot++;
+    }
+
+    return NULL;
+}
+
+//The arguments behind the name of a command with arguments, false when they are not one or two numbers
+static bool command_arguments(const uint8_t* text, uint16_t length, int32_t* value)
+{
+    uint32_t numbers[2] = { 0, 0 };
+    uint8_t count = 1;
+    bool digits = false;
+
+    for (uint16_t i = 0; i < length; i++)
+    {
+        if (text[i] >= '0' && text[i] <= '9' && numbers[count - 1] <= (INT32_MAX / 10))
+        {
+            numbers[count - 1] = numbers[count - 1] * 10 + (text[i] - '0');
+            digits = true;
+        }
+        else if (text[i] == ',' && digits && count == 1)
+        {
+            count++;
+            digits = false;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if (!digits)
+    {
+        return false;
+    }
+
+    if (count == 1)
+    {
+        *value = (int32_t)numbers[0];
+        return numbers[0] <= INT32_MAX;
+    }
+
+    *value = (int32_t)((numbers[0] << 16) | numbers[1]);
+    return numbers[0] <= COMMAND_ARGUMENT_MAX && numbers[1] <= COMMAND_ARGUMENT_MAX;
+}
+
+//A command with arguments: the name is everything before the first digit
+static const command_t* command_lookup_arguments(const uint8_t* text, uint16_t length, int32_t* value)
+{
+    uint16_t name = 0;
+
+    while (name < length && (text[name] < '0' || text[name] > '9'))
+    {
+        name++;
+    }
+
+    if (name == 0 || name == length)
+    {
+        return NULL;
+    }
+
+    const command_t* command = command_lookup(text, name);
+
+    if (command == NULL || !command->argument || !command_arguments(text + name, length - name, value))
+    {
+        return NULL;
+    }
+
+    return command;
+}
+
+//Finds the next known command behind consumed in a window of size bytes, and moves consumed past it.
+//Unknown commands are skipped. A window filled to capacity without a terminator never completes and is dropped.
+//Returns false when only an incomplete command, or nothing, is left.
+bool command_next(const uint8_t* window, uint16_t size, uint16_t capacity, uint16_t* consumed, const command_t** command, int32_t* value)
+{
+    while (*consumed < size)
+    {
+        const uint8_t* start = window + *consumed;
+        const uint8_t* end = memchr(start, COMMAND_TERMINATOR, size - *consumed);
+
+        if (!end)
+        {
+            if (*consumed == 0 && size == capacity)
+            {
+                *consumed = size;
+            }
+            return false;
+        }
+
+        *consumed = end - window + 1;
+
+        //Commands without arguments are found in one lookup, SET1 is a name of its own
+        if ((*command = command_lookup(start, end - start)) != NULL && !(*command)->argument)
+        {
+            *value = (*command)->value;
+            return true;
+        }
+
+        if ((*command = command_lookup_arguments(start, end - start, value)) != NULL)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,27 @@
+#ifndef D2A95E71_4C08_4B3F_8E6D_A17B35C9F042
+#define D2A95E71_4C08_4B3F_8E6D_A17B35C9F042
+#include <stdbool.h>
+#include <stdint.h>
+
+//Text commands are a name terminated by '#'. The names are found through a hash index over the
+//command table, built once by command_initialize, instead of a strcmp per known command.
+//A command with arguments has decimal numbers behind its name, one or two separated by ','.
+//One argument is the value, two are packed as first << 16 | second.
+#define COMMAND_TERMINATOR      '#'
+#define COMMAND_HASH_SIZE       64      // power of two, at least twice the number of commands
+#define COMMAND_ARGUMENT_MAX    0xffff  // largest number of a command with two arguments
+
+typedef struct command_t
+{
+    const char* name;
+    uint8_t length;
+    uint8_t message_type;       //MSG_ type handed to the server
+    int32_t value;
+    bool argument;              //The value follows the name
+} command_t;
+
+void command_initialize(void);
+const command_t* command_lookup(const uint8_t* text, uint16_t length);
+bool command_next(const uint8_t* window, uint16_t size, uint16_t capacity, uint16_t* consumed, const command_t** command, int32_t* value);
+
+#endif /* D2A95E71_4C08_4B3F_8E6D_A17B35C9F042 */
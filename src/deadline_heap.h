@@ -0,0 +1,140 @@
+#ifndef D4E1A9C3_2B7F_4E58_8C06_9F3A5D2B7E14
+#define D4E1A9C3_2B7F_4E58_8C06_9F3A5D2B7E14
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DEADLINE_HEAP_SIZE  8       // owners 0 to 7, one per W5x00 socket
+#define DEADLINE_NONE       0xff
+
+//Binary min-heap of the next deadline of every owner, an owner has at most one.
+//The earliest deadline is at the root, so the scheduler does not look at owners whose time has not come.
+typedef struct deadline_heap_t
+{
+    uint8_t count;
+    uint8_t owners[DEADLINE_HEAP_SIZE];         //Heap order
+    uint8_t index[DEADLINE_HEAP_SIZE];          //Position of an owner in owners, DEADLINE_NONE without a deadline
+    uint64_t at[DEADLINE_HEAP_SIZE];            //Deadline of an owner, time_us_64
+} deadline_heap_t;
+
+static inline void deadline_heap_reset(deadline_heap_t* heap)
+{
+    heap->count = 0;
+
+    for (uint8_t owner = 0; owner < DEADLINE_HEAP_SIZE; owner++)
+    {
+        heap->index[owner] = DEADLINE_NONE;
+    }
+}
+
+static inline void deadline_heap_swap(deadline_heap_t* heap, uint8_t a, uint8_t b)
+{
+    uint8_t owner = heap->owners[a];
+
+    heap->owners[a] = heap->owners[b];
+    heap->owners[b] = owner;
+    heap->index[heap->owners[a]] = a;
+    heap->index[heap->owners[b]] = b;
+}
+
+static inline void deadline_heap_up(deadline_heap_t* heap, uint8_t pos)
+{
+    while (pos > 0)
+    {
+        uint8_t parent = (pos - 1) / 2;
+
+        if (heap->at[heap->owners[parent]] <= heap->at[heap->owners[pos]])
+        {
+            break;
+        }
+
+        deadline_heap_swap(heap, parent, pos);
+        pos = parent;
+    }
+}
+
+static inline void deadline_heap_down(deadline_heap_t* heap, uint8_t pos)
+{
+    while (true)
+    {
+        uint8_t left = 2 * pos + 1;
+        uint8_t right = left + 1;
+        uint8_t earliest = pos;
+
+        if (left < heap->count && heap->at[heap->owners[left]] < heap->at[heap->owners[earliest]])
+        {
+            earliest = left;
+        }
+
+        if (right < heap->count && heap->at[heap->owners[right]] < heap->at[heap->owners[earliest]])
+        {
+            earliest = right;
+        }
+
+        if (earliest == pos)
+        {
+            break;
+        }
+
+        deadline_heap_swap(heap, pos, earliest);
+        pos = earliest;
+    }
+}
+
+static inline void deadline_heap_cancel(deadline_heap_t* heap, uint8_t owner)
+{
+    uint8_t pos = heap->index[owner];
+
+    if (pos == DEADLINE_NONE)
+    {
+        return;
+    }
+
+    heap->count--;
+    if (pos != heap->count)
+    {
+        deadline_heap_swap(heap, pos, heap->count);
+        deadline_heap_up(heap, pos);
+        deadline_heap_down(heap, pos);
+    }
+    heap->index[owner] = DEADLINE_NONE;
+}
+
+//Sets or moves the deadline of an owner
+static inline void deadline_heap_set(deadline_heap_t* heap, uint8_t owner, uint64_t at)
+{
+    uint8_t pos = heap->index[owner];
+
+    heap->at[owner] = at;
+
+    if (pos == DEADLINE_NONE)
+    {
+        pos = heap->count++;
+        heap->owners[pos] = owner;
+        heap->index[owner] = pos;
+    }
+
+    deadline_heap_up(heap, pos);
+    deadline_heap_down(heap, heap->index[owner]);
+}
+
+//Earliest deadline, UINT64_MAX when no owner has one
+static inline uint64_t deadline_heap_next(const deadline_heap_t* heap)
+{
+    return heap->count ? heap->at[heap->owners[0]] : UINT64_MAX;
+}
+
+//Removes the earliest deadline when it passed, false when none did
+static inline bool deadline_heap_expired(deadline_heap_t* heap, uint64_t now, uint8_t* owner)
+{
+    if (heap->count == 0 || heap->at[heap->owners[0]] > now)
+    {
+        return false;
+    }
+
+    *owner = heap->owners[0];
+    deadline_heap_cancel(heap, *owner);
+
+    return true;
+}
+
+#endif /* D4E1A9C3_2B7F_4E58_8C06_9F3A5D2B7E14 */
@@ -0,0 +1,71 @@
+#include "flash_region.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "network_core.h"
+
+#define FLASH_REGION_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_REGION_SIZE)
+
+#if FLASH_REGION_SECTOR_SIZE != FLASH_SECTOR_SIZE || FLASH_REGION_PAGE_SIZE != FLASH_PAGE_SIZE
+#error "The flash region has to use the sector and page size of the pico-sdk"
+#endif
+
+//End of the firmware image in flash, from the linker script of the pico-sdk
+extern char __flash_binary_end;
+
+//No code runs from flash while the XIP is off: interrupts on this core and the network core are held
+static uint32_t flash_region_lock(void)
+{
+#ifdef NETWORK_CORE1
+    network_core_pause();
+#endif
+    return save_and_disable_interrupts();
+}
+
+static void flash_region_unlock(uint32_t interrupts)
+{
+    restore_interrupts(interrupts);
+#ifdef NETWORK_CORE1
+    network_core_resume();
+#endif
+}
+
+//False when the firmware image grew into the region
+bool flash_region_initialize(void)
+{
+    uint32_t image_end = (uint32_t)((uintptr_t)&__flash_binary_end - XIP_BASE);
+
+    if (image_end > FLASH_REGION_OFFSET)
+    {
+        printf("Firmware image ends at %ld, flash region at %ld is not used\n", image_end, (uint32_t)FLASH_REGION_OFFSET);
+        return false;
+    }
+
+    return true;
+}
+
+//Through the XIP cache, the region is mapped like the rest of the flash
+void flash_region_read(uint32_t offset, void* data, uint32_t size)
+{
+    memcpy(data, (const void*)(uintptr_t)(XIP_BASE + FLASH_REGION_OFFSET + offset), size);
+}
+
+void flash_region_erase(uint8_t sector)
+{
+    uint32_t interrupts = flash_region_lock();
+
+    flash_range_erase(FLASH_REGION_OFFSET + sector * FLASH_REGION_SECTOR_SIZE, FLASH_REGION_SECTOR_SIZE);
+    flash_region_unlock(interrupts);
+}
+
+//One page at a page aligned offset, bytes left at 0xff do not change the flash
+void flash_region_program(uint32_t offset, const uint8_t* page)
+{
+    uint32_t interrupts = flash_region_lock();
+
+    flash_range_program(FLASH_REGION_OFFSET + offset, page, FLASH_REGION_PAGE_SIZE);
+    flash_region_unlock(interrupts);
+}
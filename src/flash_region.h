@@ -0,0 +1,20 @@
+#ifndef B3F8D2A6_1C47_4E95_A0D3_6E2C9B7F4A18
+#define B3F8D2A6_1C47_4E95_A0D3_6E2C9B7F4A18
+#include <stdbool.h>
+#include <stdint.h>
+
+//Sectors at the end of the QSPI flash that the firmware image never reaches, for data kept across reboots.
+//NOR flash: an erase sets a sector to 0xff, a program only clears bits of whole pages.
+//Erase and program stop the XIP of both cores, core 0 runs them with interrupts disabled and the
+//network core, when it runs, waits in RAM until they are done.
+#define FLASH_REGION_SECTORS        4
+#define FLASH_REGION_SECTOR_SIZE    4096    // FLASH_SECTOR_SIZE of the pico-sdk
+#define FLASH_REGION_PAGE_SIZE      256     // FLASH_PAGE_SIZE of the pico-sdk
+#define FLASH_REGION_SIZE           (FLASH_REGION_SECTORS * FLASH_REGION_SECTOR_SIZE)
+
+bool flash_region_initialize(void);
+void flash_region_read(uint32_t offset, void* data, uint32_t size);
+void flash_region_erase(uint8_t sector);
+void flash_region_program(uint32_t offset, const uint8_t* page);
+
+#endif /* B3F8D2A6_1C47_4E95_A0D3_6E2C9B7F4A18 */
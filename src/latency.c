@@ -0,0 +1,90 @@
+#include "latency.h"
+
+#include <stdio.h>
+
+static const char* latency_stage_names[LATENCY_STAGE_COUNT] =
+{
+    "parse", "receive queue", "control", "send queue", "send", "total"
+};
+
+static latency_histogram_t latency_histograms[LATENCY_STAGE_COUNT];
+
+static uint8_t latency_bucket(uint32_t us)
+{
+    uint8_t bucket = (us > 1) ? (31 - __builtin_clz(us)) : 0;
+
+    return (bucket < LATENCY_BUCKETS) ? bucket : (LATENCY_BUCKETS - 1);
+}
+
+static void latency_add(uint8_t stage, uint32_t us)
+{
+    latency_histogram_t* histogram = &latency_histograms[stage];
+
+    histogram->buckets[latency_bucket(us)]++;
+    histogram->count++;
+
+    if (us > histogram->max_us)
+    {
+        histogram->max_us = us;
+    }
+}
+
+//All stages of a command whose reply left, the timestamps wrap after 71 minutes like the differences.
+//Stage n is the time from hop n to hop n + 1.
+void latency_record(const uint32_t hops[HOP_COUNT])
+{
+    for (uint8_t hop = HOP_RECEIVED; hop < HOP_SENT; hop++)
+    {
+        latency_add(hop, hops[hop + 1] - hops[hop]);
+    }
+
+    latency_add(LATENCY_STAGE_TOTAL, hops[HOP_SENT] - hops[HOP_RECEIVED]);
+}
+
+//Interpolated in the bucket that holds the percentile, at most the largest latency seen
+uint32_t latency_percentile(uint8_t stage, uint16_t permille)
+{
+    const latency_histogram_t* histogram = &latency_histograms[stage];
+    uint64_t rank = ((uint64_t)histogram->count * permille + 999) / 1000;
+    uint32_t seen = 0;
+
+    if (histogram->count == 0)
+    {
+        return 0;
+    }
+
+    for (uint8_t bucket = 0; bucket < LATENCY_BUCKETS - 1; bucket++)
+    {
+        uint32_t count = histogram->buckets[bucket];
+
+        if (seen + count >= rank)
+        {
+            uint32_t lower = bucket ? (1u << bucket) : 0;
+            uint32_t width = bucket ? (1u << bucket) : 2;
+            uint32_t us = lower + (uint32_t)((width * (rank - seen) - 1) / count);
+
+            return (us < histogram->max_us) ? us : histogram->max_us;
+        }
+
+        seen += count;
+    }
+
+    return histogram->max_us;
+}
+
+const latency_histogram_t* latency_histogram(uint8_t stage)
+{
+    return &latency_histograms[stage];
+}
+
+void latency_print_stats(void)
+{
+    for (uint8_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+    {
+        const latency_histogram_t* histogram = &latency_histograms[stage];
+
+        printf("Latency %s: %lu commands, p50 %lu us, p99 %lu us, max %lu us\n",
+               latency_stage_names[stage], histogram->count, latency_percentile(stage, 500),
+               latency_percentile(stage, 990), histogram->max_us);
+    }
+}
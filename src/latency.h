@@ -0,0 +1,49 @@
+#ifndef E5BF9EBE_848B_4CEE_A08B_FA832364F445
+#define E5BF9EBE_848B_4CEE_A08B_FA832364F445
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+#include "pico/stdlib.h"
+
+//Latency of a command per stage between two hops, in histograms with power of two buckets:
+//bucket 0 counts 0 and 1 us, bucket n counts 2^n to 2^(n+1) - 1 us, the last one everything above.
+//Percentiles are interpolated inside their bucket. Recorded and read by the server only, when the reply left.
+#define LATENCY_BUCKETS         24      // the last bucket starts at 8.4 s
+
+#define LATENCY_STAGE_PARSE         0   // HOP_RECEIVED to HOP_DELIVERED
+#define LATENCY_STAGE_RECEIVE_QUEUE 1   // HOP_DELIVERED to HOP_DEQUEUED
+#define LATENCY_STAGE_CONTROL       2   // HOP_DEQUEUED to HOP_REPLIED
+#define LATENCY_STAGE_SEND_QUEUE    3   // HOP_REPLIED to HOP_REPLY_TAKEN
+#define LATENCY_STAGE_SEND          4   // HOP_REPLY_TAKEN to HOP_SENT
+#define LATENCY_STAGE_TOTAL         5   // HOP_RECEIVED to HOP_SENT
+#define LATENCY_STAGE_COUNT         6
+
+typedef struct latency_histogram_t
+{
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+} latency_histogram_t;
+
+//Timestamp of a hop, 0 is kept for untraced messages
+static inline uint32_t latency_timestamp(uint64_t us)
+{
+    return ((uint32_t)us) ? (uint32_t)us : 1;
+}
+
+static inline void latency_stamp(message_t* message, uint8_t hop)
+{
+    message->hops[hop] = latency_timestamp(time_us_64());
+}
+
+static inline bool latency_traced(const message_t* message)
+{
+    return message->hops[HOP_RECEIVED] != 0;
+}
+
+void latency_record(const uint32_t hops[HOP_COUNT]);
+uint32_t latency_percentile(uint8_t stage, uint16_t permille);
+const latency_histogram_t* latency_histogram(uint8_t stage);
+void latency_print_stats(void);
+
+#endif /* E5BF9EBE_848B_4CEE_A08B_FA832364F445 */
@@ -30,6 +30,9 @@
 #include "ventcontrol.h"
 #include "types.h"
 #include "timer.h"
+#include "socket_memory.h"
+#include "message_pool.h"
+#include "network_core.h"
 
 /**
  * ----------------------------------------------------------------------------------------------------
@@ -43,6 +46,9 @@
 #define SERVER_TASK_STACK_SIZE 2048
 #define SERVER_TASK_PRIORITY 4
 
+#define BENCH_TASK_STACK_SIZE 512
+#define BENCH_TASK_PRIORITY 8
+
 /* Clock */
 #define PLL_SYS_KHZ (133 * 1000)
 
@@ -135,20 +141,47 @@ int main()
     wizchip_reset();
     wizchip_initialize();
     wizchip_check();
+    wizchip_spi_calibrate();
     setSHAR(g_net_info.mac);
     dhcpHostName("ventcontrol");
 
     wizchip_1ms_timer_initialize(repeating_timer_callback);
     server_data.ip_assigned_sem = xSemaphoreCreateCounting((unsigned portBASE_TYPE)0x7fffffff, (unsigned portBASE_TYPE)0);
     server_data.server_run = false;
-    server_data.receive_queue = xQueueCreate(MAX_QUEUE_LENGTH, sizeof(message_t));
-    server_data.send_queue = xQueueCreate(MAX_QUEUE_LENGTH, sizeof(message_t));
+    //The queues carry pointers to blocks of the message pool
+    message_pool_initialize();
+    server_data.receive_queue = xQueueCreate(MAX_QUEUE_LENGTH, sizeof(message_t*));
+    server_data.send_queue = xQueueCreate(MAX_QUEUE_LENGTH, sizeof(message_t*));
     server_data.blink_queue = xQueueCreate(MAX_QUEUE_LENGTH, sizeof(int));
+    server_data.server_task = NULL;
 
     printf("Creating task ....\n");
+#if defined(USE_SPI_DMA) && defined(USE_SPI_DMA_BENCHMARK)
+    xTaskCreate(wizchip_dma_benchmark_task, "Bench_Task", BENCH_TASK_STACK_SIZE, NULL, BENCH_TASK_PRIORITY, NULL);
+#elif defined(NETWORK_CORE1)
+    //Listeners get their memory when the server starts
+    socket_memory_initialize();
+
+    //From here on only core 1 uses the W5x00
+    if (g_net_info.dhcp == NETINFO_DHCP)
+    {
+        network_core_launch(&server_data, wizchip_dhcp_init);
+    }
+    else
+    {
+        network_initialize(g_net_info);
+        print_network_information(g_net_info);
+        network_core_launch(&server_data, NULL);
+    }
+    xTaskCreate(ventcontrol_task, "Ventcontrol_TASK", SERVER_TASK_STACK_SIZE, &server_data, SERVER_TASK_PRIORITY, NULL);
+#else
+    //Listeners get their memory when the server starts
+    socket_memory_initialize();
+
     xTaskCreate(dhcp_task, "DHCP_Task", DHCP_TASK_STACK_SIZE, &server_data, DHCP_TASK_PRIORITY, NULL);
     xTaskCreate(server_task, "Server_TASK", SERVER_TASK_STACK_SIZE, &server_data, SERVER_TASK_PRIORITY, NULL);
     xTaskCreate(ventcontrol_task, "Ventcontrol_TASK", SERVER_TASK_STACK_SIZE, &server_data, SERVER_TASK_PRIORITY, NULL);
+#endif
 
     vTaskStartScheduler();
 
@@ -312,7 +345,11 @@ static void wizchip_dhcp_conflict(void)
     // halt or reset or any...
     while (1)
     {
+#ifdef NETWORK_CORE1
+        __wfe(); // DHCP runs on core 1, outside FreeRTOS
+#else
         vTaskDelay(1000 * 1000);
+#endif
     }
 }
 
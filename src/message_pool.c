@@ -0,0 +1,123 @@
+#include "message_pool.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/critical_section.h"
+
+typedef struct message_block_t
+{
+    message_t message;                  //First, a message pointer is the block pointer
+    uint8_t refs;
+    uint8_t next_free;
+} message_block_t;
+
+#define MESSAGE_POOL_END    0xff
+
+static message_block_t message_blocks[MESSAGE_POOL_SIZE];
+static uint8_t message_free = MESSAGE_POOL_END;
+static message_pool_stats_t message_pool_stats;
+
+//Both cores take and release blocks with NETWORK_CORE1, the spin lock also keeps interrupts out
+static critical_section_t message_pool_lock;
+
+void message_pool_initialize(void)
+{
+    critical_section_init(&message_pool_lock);
+
+    for (uint8_t i = 0; i < MESSAGE_POOL_SIZE; i++)
+    {
+        message_blocks[i].refs = 0;
+        message_blocks[i].next_free = (i + 1 < MESSAGE_POOL_SIZE) ? (i + 1) : MESSAGE_POOL_END;
+    }
+
+    message_free = 0;
+    memset(&message_pool_stats, 0, sizeof(message_pool_stats));
+    message_pool_stats.size = MESSAGE_POOL_SIZE;
+}
+
+//A block with one reference and the hops cleared, NULL when the pool is empty
+message_t* message_alloc(void)
+{
+    message_block_t* block = NULL;
+
+    critical_section_enter_blocking(&message_pool_lock);
+
+    if (message_free != MESSAGE_POOL_END)
+    {
+        block = &message_blocks[message_free];
+        message_free = block->next_free;
+        block->refs = 1;
+
+        message_pool_stats.allocations++;
+        message_pool_stats.in_use++;
+        if (message_pool_stats.in_use > message_pool_stats.max_in_use)
+        {
+            message_pool_stats.max_in_use = message_pool_stats.in_use;
+        }
+    }
+    else
+    {
+        message_pool_stats.failures++;
+    }
+
+    critical_section_exit(&message_pool_lock);
+
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    memset(block->message.hops, 0, sizeof(block->message.hops));
+
+    return &block->message;
+}
+
+//Another holder of the message, it releases the message on its own
+message_t* message_ref(message_t* message)
+{
+    message_block_t* block = (message_block_t*)message;
+
+    critical_section_enter_blocking(&message_pool_lock);
+    block->refs++;
+    critical_section_exit(&message_pool_lock);
+
+    return message;
+}
+
+void message_release(message_t* message)
+{
+    message_block_t* block = (message_block_t*)message;
+
+    if (message == NULL)
+    {
+        return;
+    }
+
+    critical_section_enter_blocking(&message_pool_lock);
+
+    if (--block->refs == 0)
+    {
+        block->next_free = message_free;
+        message_free = block - message_blocks;
+        message_pool_stats.in_use--;
+    }
+
+    critical_section_exit(&message_pool_lock);
+}
+
+void message_pool_get_stats(message_pool_stats_t* stats)
+{
+    critical_section_enter_blocking(&message_pool_lock);
+    *stats = message_pool_stats;
+    critical_section_exit(&message_pool_lock);
+}
+
+void message_pool_print_stats(void)
+{
+    message_pool_stats_t stats;
+
+    message_pool_get_stats(&stats);
+
+    printf("Message pool: %d of %d blocks in use (max %d), %ld allocations, %ld failed\n",
+           stats.in_use, stats.size, stats.max_in_use, stats.allocations, stats.failures);
+}
@@ -0,0 +1,28 @@
+#ifndef C7A2E5F9_4B1D_4D63_9E8A_2F6B0C3D1E58
+#define C7A2E5F9_4B1D_4D63_9E8A_2F6B0C3D1E58
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+
+//Fixed blocks for the messages between the server and the control tasks. The queues and rings carry
+//pointers, a message is filled once and read in place by every task it passes.
+//A block has a reference count, every holder releases its reference and the last one frees the block.
+#define MESSAGE_POOL_SIZE       48      // receive_queue and send_queue, the two rings of NETWORK_CORE1 and the messages in work
+
+typedef struct message_pool_stats_t
+{
+    uint16_t size;
+    uint16_t in_use;
+    uint16_t max_in_use;                //High-water mark
+    uint32_t allocations;
+    uint32_t failures;                  //Allocations without a free block
+} message_pool_stats_t;
+
+void message_pool_initialize(void);
+message_t* message_alloc(void);
+message_t* message_ref(message_t* message);
+void message_release(message_t* message);
+void message_pool_get_stats(message_pool_stats_t* stats);
+void message_pool_print_stats(void);
+
+#endif /* C7A2E5F9_4B1D_4D63_9E8A_2F6B0C3D1E58 */
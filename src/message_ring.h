@@ -0,0 +1,67 @@
+#ifndef E4D7A1B9_2C6F_4E83_B5A0_91F3C8D26E47
+#define E4D7A1B9_2C6F_4E83_B5A0_91F3C8D26E47
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/sync.h"
+#include "types.h"
+
+#define MESSAGE_RING_SIZE    16     // power of two
+
+//Lock-free ring of message pool pointers for one producer and one consumer, one on each core.
+//head is only written by the producer, tail only by the consumer.
+typedef struct message_ring_t
+{
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    message_t* messages[MESSAGE_RING_SIZE];
+} message_ring_t;
+
+static inline bool message_ring_empty(const message_ring_t* ring)
+{
+    return ring->head == ring->tail;
+}
+
+static inline bool message_ring_full(const message_ring_t* ring)
+{
+    return (ring->head - ring->tail) == MESSAGE_RING_SIZE;
+}
+
+static inline bool message_ring_put(message_ring_t* ring, message_t* message)
+{
+    uint32_t head = ring->head;
+
+    if ((head - ring->tail) == MESSAGE_RING_SIZE)
+    {
+        return false;
+    }
+
+    ring->messages[head % MESSAGE_RING_SIZE] = message;
+
+    //The message is complete before the consumer can see it
+    __dmb();
+    ring->head = head + 1;
+
+    return true;
+}
+
+static inline bool message_ring_get(message_ring_t* ring, message_t** message)
+{
+    uint32_t tail = ring->tail;
+
+    if (ring->head == tail)
+    {
+        return false;
+    }
+
+    //Read the pointer and the message behind it only after seeing the new head
+    __dmb();
+    *message = ring->messages[tail % MESSAGE_RING_SIZE];
+
+    //The message is read before the producer can reuse the slot
+    __dmb();
+    ring->tail = tail + 1;
+
+    return true;
+}
+
+#endif /* E4D7A1B9_2C6F_4E83_B5A0_91F3C8D26E47 */
@@ -0,0 +1,370 @@
+#include "network_core.h"
+
+#include "server.h"
+#include "message_ring.h"
+#include "message_pool.h"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "wizchip_conf.h"
+#include "dhcp.h"
+#include <stdio.h>
+
+#ifdef NETWORK_CORE1
+
+//Core 1 owns the W5x00 and runs DHCP and the tcp server without FreeRTOS.
+//Messages of tcp clients and their replies pass through the rings, the inter-core FIFO only wakes up.
+static message_ring_t receive_ring;     //core 1 -> core 0
+static message_ring_t send_ring;        //core 0 -> core 1
+
+static server_data_t* network_server_data = NULL;
+static void (*network_dhcp_init)(void) = NULL;
+static TaskHandle_t network_bridge_task_handle = NULL;
+static alarm_pool_t* network_alarm_pool = NULL;
+static volatile bool network_interrupt = false;
+static bool network_delivered = false;
+static uint32_t network_core_stack[NETWORK_CORE_STACK_SIZE / sizeof(uint32_t)];
+static bool network_launched = false;
+static volatile bool network_pause_requested = false;
+static volatile bool network_paused = false;
+
+static void network_core_wake(void)
+{
+    //A full FIFO already holds a wake up for the other core
+    if (multicore_fifo_wready())
+    {
+        multicore_fifo_push_blocking(NETWORK_CORE_WAKE);
+    }
+}
+
+/* Core 1 */
+//Called from the W5x00 INT pin interrupt on core 1, returning from the interrupt ends the __wfe
+static void network_core_interrupt_callback(void)
+{
+    network_interrupt = true;
+    __sev();
+}
+
+//Waits in RAM with interrupts disabled while core 0 has the XIP off for a flash erase or program
+static void __not_in_flash_func(network_core_park)(void)
+{
+    uint32_t interrupts = save_and_disable_interrupts();
+
+    network_paused = true;
+    while (network_pause_requested)
+    {
+        tight_loop_contents();
+    }
+    network_paused = false;
+
+    restore_interrupts(interrupts);
+}
+
+//Only here to end the __wfe
+static int64_t network_core_alarm_callback(alarm_id_t id, void* user_data)
+{
+    __sev();
+    return 0;
+}
+
+static bool network_core_deliver(message_t* message)
+{
+    if (!message_ring_put(&receive_ring, message))
+    {
+        return false;
+    }
+
+    network_delivered = true;
+    return true;
+}
+
+//The dhcp_task loop without blocking, returns true while the IP address is leased
+static bool network_core_dhcp(void)
+{
+    static bool link_up = false;
+    static bool leased = false;
+    static bool failed = false;
+    static uint32_t dhcp_retry = 0;
+
+    if (network_dhcp_init == NULL)
+    {
+        //Static IP address, set by core 0
+        return true;
+    }
+
+    if (wizphy_getphylink() == PHY_LINK_OFF)
+    {
+        if (link_up)
+        {
+            printf("PHY_LINK_OFF\n");
+            DHCP_stop();
+            link_up = false;
+            leased = false;
+        }
+        return false;
+    }
+
+    if (!link_up)
+    {
+        network_dhcp_init();
+        link_up = true;
+        dhcp_retry = 0;
+    }
+
+    if (failed)
+    {
+        return false;
+    }
+
+    int retval = DHCP_run();
+
+    if (retval == DHCP_IP_LEASED)
+    {
+        if (!leased)
+        {
+            printf(" DHCP success\n");
+            leased = true;
+            dhcp_retry = 0;
+        }
+    }
+    else if (retval == DHCP_FAILED)
+    {
+        leased = false;
+        dhcp_retry++;
+
+        if (dhcp_retry <= NETWORK_CORE_DHCP_RETRY_COUNT)
+        {
+            printf(" DHCP timeout occurred and retry %d\n", dhcp_retry);
+        }
+        else
+        {
+            printf(" DHCP failed\n");
+            DHCP_stop();
+            failed = true;
+        }
+    }
+
+    return leased;
+}
+
+static void network_core_entry(void)
+{
+    bool serving = false;
+    uint64_t next_poll = UINT64_MAX;
+    uint64_t now = time_us_64();
+    uint64_t next_dhcp = now;
+    uint64_t next_sweep = now;
+    const uint64_t sweep_us = (uint64_t)SERVER_SWEEP_TICKS * portTICK_PERIOD_MS * 1000;
+
+    //Alarms of this pool interrupt core 1
+    network_alarm_pool = alarm_pool_create(NETWORK_CORE_HARDWARE_ALARM, 4);
+
+    printf("Network engine running on core %d\n", get_core_num());
+
+    while (true)
+    {
+        message_t* send_message;
+        bool leased = serving;
+
+        //Between two passes, the W5x00 and the rings are not in use
+        if (network_pause_requested)
+        {
+            network_core_park();
+        }
+
+        now = time_us_64();
+
+        if (now >= next_dhcp)
+        {
+            next_dhcp = now + NETWORK_CORE_DHCP_POLL_US;
+            leased = network_core_dhcp();
+        }
+
+        if (leased && !serving)
+        {
+            printf("IP Assigned, starting tcp server.\n");
+            server_start(network_core_interrupt_callback);
+            serving = true;
+            next_sweep = now + sweep_us;
+            next_poll = now;
+        }
+        else if (!leased && serving)
+        {
+            server_stop();
+            serving = false;
+            printf("\nTcp server stopping\n");
+        }
+
+        //The FIFO words only wake up, the rings are checked below
+        while (multicore_fifo_rvalid())
+        {
+            (void)multicore_fifo_pop_blocking();
+        }
+
+        if (serving)
+        {
+            bool was_full = message_ring_full(&send_ring);
+            bool sweep = (now >= next_sweep) && server_sweep_pending();
+
+            send_message = NULL;
+            bool replied = message_ring_get(&send_ring, &send_message);
+
+            if (sweep)
+            {
+                next_sweep = now + sweep_us;
+            }
+
+            if (replied || sweep || network_interrupt || now >= next_poll)
+            {
+                network_interrupt = false;
+                next_poll = server_poll(send_message, sweep, network_core_deliver);
+            }
+
+            message_release(send_message);
+
+            //Client messages for core 0, or room for the replies core 0 could not pass yet
+            if (network_delivered || was_full)
+            {
+                network_delivered = false;
+                network_core_wake();
+            }
+
+            //One reply per poll, like the server_task
+            if (!message_ring_empty(&send_ring))
+            {
+                continue;
+            }
+        }
+
+        //Sleep until the W5x00 interrupt, a FIFO word from core 0 or the next deadline
+        uint64_t deadline = next_dhcp;
+
+        //No sweep without a memory profile to apply, an idle pool only wakes up for the W5x00
+        if (serving && next_sweep < deadline && server_sweep_pending())
+        {
+            deadline = next_sweep;
+        }
+
+        if (serving && next_poll < deadline)
+        {
+            deadline = next_poll;
+        }
+
+        alarm_id_t alarm = alarm_pool_add_alarm_at(network_alarm_pool, from_us_since_boot(deadline), network_core_alarm_callback, NULL, false);
+        if (alarm > 0)
+        {
+            if (!network_interrupt && !multicore_fifo_rvalid())
+            {
+                __wfe();
+            }
+            alarm_pool_cancel_alarm(network_alarm_pool, alarm);
+        }
+    }
+}
+
+/* Core 0 */
+static void network_core_fifo_irq_handler(void)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    while (multicore_fifo_rvalid())
+    {
+        (void)multicore_fifo_pop_blocking();
+    }
+    multicore_fifo_clear_irq();
+
+    if (network_bridge_task_handle != NULL)
+    {
+        vTaskNotifyGiveFromISR(network_bridge_task_handle, &higher_priority_task_woken);
+    }
+
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+//Moves the messages between the rings and the queues of the control tasks
+static void network_core_bridge_task(void* params)
+{
+    message_t* message;
+
+    while (true)
+    {
+        bool sent = false;
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (!message_ring_full(&send_ring) && xQueueReceive(network_server_data->send_queue, (void *)&message, 0) == pdTRUE)
+        {
+            message_ring_put(&send_ring, message);
+            sent = true;
+        }
+
+        if (sent)
+        {
+            network_core_wake();
+        }
+
+        while (message_ring_get(&receive_ring, &message))
+        {
+            if (xQueueSend(network_server_data->receive_queue, (void *)&message, 10) != pdTRUE)
+            {
+                message_release(message);
+                printf("\nUnable to put message on receive_queue\n");
+            }
+        }
+    }
+}
+
+//Core 0: returns once core 1 runs from RAM, it finishes the pass over the server it is in first
+void network_core_pause(void)
+{
+    if (!network_launched)
+    {
+        return;
+    }
+
+    network_pause_requested = true;
+    network_core_wake();
+
+    while (!network_paused)
+    {
+        tight_loop_contents();
+    }
+}
+
+//Core 0: returns once core 1 left the RAM loop, a pause right after it cannot see the old network_paused
+void network_core_resume(void)
+{
+    if (!network_launched)
+    {
+        return;
+    }
+
+    network_pause_requested = false;
+
+    while (network_paused)
+    {
+        tight_loop_contents();
+    }
+}
+
+void network_core_launch(server_data_t* server_data, void (*dhcp_init)(void))
+{
+    network_server_data = server_data;
+    network_dhcp_init = dhcp_init;
+
+    xTaskCreate(network_core_bridge_task, "Network_Bridge_Task", NETWORK_BRIDGE_TASK_STACK_SIZE, NULL, NETWORK_BRIDGE_TASK_PRIORITY, &network_bridge_task_handle);
+
+    //Replies put on the send_queue wake up the bridge
+    server_data->server_task = network_bridge_task_handle;
+
+    //The launch handshake uses the FIFO, install the handler afterwards
+    multicore_launch_core1_with_stack(network_core_entry, network_core_stack, sizeof(network_core_stack));
+    network_launched = true;
+
+    multicore_fifo_clear_irq();
+    irq_set_exclusive_handler(SIO_IRQ_PROC0, network_core_fifo_irq_handler);
+    irq_set_enabled(SIO_IRQ_PROC0, true);
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef F5B2E8C4_A1D3_4F69_8E0B_C7D41A9F3E62
+#define F5B2E8C4_A1D3_4F69_8E0B_C7D41A9F3E62
+#include "types.h"
+
+//#define NETWORK_CORE1                     // if you want core 1 to own the W5x00 (DHCP, tcp server and SPI), uncomment.
+
+#define NETWORK_CORE_DHCP_POLL_US       (10 * 1000)     // DHCP_run interval, the dhcp_task delay
+#define NETWORK_CORE_DHCP_RETRY_COUNT   5
+#define NETWORK_CORE_HARDWARE_ALARM     2               // wakes core 1, the default alarm pool uses 3
+#define NETWORK_CORE_STACK_SIZE         4096            // bytes, core 1 runs DHCP and the server on this stack
+#define NETWORK_BRIDGE_TASK_STACK_SIZE  512
+#define NETWORK_BRIDGE_TASK_PRIORITY    8
+#define NETWORK_CORE_WAKE               0x4E455457      // inter-core FIFO word, the rings hold the data
+
+void network_core_launch(server_data_t* server_data, void (*dhcp_init)(void));
+void network_core_pause(void);
+void network_core_resume(void);
+
+#endif /* F5B2E8C4_A1D3_4F69_8E0B_C7D41A9F3E62 */
@@ -0,0 +1,280 @@
+#include "program.h"
+
+#include <string.h>
+
+#define PROGRAM_DAY_US          (24ull * 60 * 60 * 1000 * 1000)
+
+typedef struct program_entry_t
+{
+    uint64_t at;                //Time of day in us
+    int speed;
+} program_entry_t;
+
+//The running program, ends_at is UINT64_MAX without one
+static int program_revert_speed = PROGRAM_NO_SPEED;
+static uint64_t program_ends_at = UINT64_MAX;
+static uint64_t program_push_us = PROGRAM_PUSH_SECONDS * 1000ull * 1000;
+static uint64_t program_next_push = UINT64_MAX;
+static bool program_push_end = false;           //The end of a program is pushed as T0
+
+static program_entry_t program_entries[PROGRAM_SCHEDULE_SIZE];
+static uint8_t program_entry_count = 0;
+static uint8_t program_next_entry = 0;
+static uint64_t program_next_entry_at = UINT64_MAX;
+
+//Time of day: clock_us was the time of day at time_us_64 clock_set_at
+static bool program_clock_valid = false;
+static uint64_t program_clock_us = 0;
+static uint64_t program_clock_set_at = 0;
+
+void program_initialize(void)
+{
+    program_revert_speed = PROGRAM_NO_SPEED;
+    program_ends_at = UINT64_MAX;
+    program_push_us = PROGRAM_PUSH_SECONDS * 1000ull * 1000;
+    program_next_push = UINT64_MAX;
+    program_push_end = false;
+    program_entry_count = 0;
+    program_next_entry_at = UINT64_MAX;
+    program_clock_valid = false;
+}
+
+//The schedule entry that comes next after now, an entry at now is a day away
+static void program_schedule_next(uint64_t now)
+{
+    program_next_entry_at = UINT64_MAX;
+
+    if (!program_clock_valid || program_entry_count == 0)
+    {
+        return;
+    }
+
+    uint64_t time_of_day = (program_clock_us + (now - program_clock_set_at)) % PROGRAM_DAY_US;
+    uint64_t earliest = UINT64_MAX;
+
+    for (uint8_t i = 0; i < program_entry_count; i++)
+    {
+        uint64_t wait = (program_entries[i].at + PROGRAM_DAY_US - time_of_day) % PROGRAM_DAY_US;
+
+        if (wait == 0)
+        {
+            wait = PROGRAM_DAY_US;
+        }
+
+        if (wait < earliest)
+        {
+            earliest = wait;
+            program_next_entry = i;
+        }
+    }
+
+    program_next_entry_at = now + earliest;
+}
+
+//Runs for minutes at the speed the caller switched to, remaining time is pushed right away and every push interval
+void program_start(uint32_t minutes, int revert_speed, uint64_t now)
+{
+    program_revert_speed = revert_speed;
+    program_ends_at = now + (uint64_t)minutes * 60 * 1000 * 1000;
+    program_next_push = now;
+    program_push_end = false;
+}
+
+//Stops the running program, returns the speed it would have reverted to or PROGRAM_NO_SPEED without one
+int program_cancel(void)
+{
+    int revert_speed = program_revert_speed;
+
+    program_revert_speed = PROGRAM_NO_SPEED;
+    program_ends_at = UINT64_MAX;
+    program_next_push = UINT64_MAX;
+    program_push_end = (revert_speed != PROGRAM_NO_SPEED);
+
+    return revert_speed;
+}
+
+bool program_running(void)
+{
+    return program_ends_at != UINT64_MAX;
+}
+
+//time_us_64 the running program reverts, UINT64_MAX without one
+uint64_t program_ends(void)
+{
+    return program_ends_at;
+}
+
+//Seconds until the running program reverts, rounded up, 0 without one
+uint32_t program_remaining_seconds(uint64_t now)
+{
+    if (!program_running() || program_ends_at <= now)
+    {
+        return 0;
+    }
+
+    return (program_ends_at - now + (1000 * 1000) - 1) / (1000 * 1000);
+}
+
+//Sets the speed every day at hhmm, an entry at the same time is replaced. False for a bad time or speed,
+//or a full schedule.
+bool program_schedule(uint16_t hhmm, int speed, uint64_t now)
+{
+    uint16_t hours = hhmm / 100;
+    uint16_t minutes = hhmm % 100;
+
+    if (hours > 23 || minutes > 59 || speed < 0 || speed > PROGRAM_MAX_SPEED)
+    {
+        return false;
+    }
+
+    uint64_t at = (hours * 60ull + minutes) * 60 * 1000 * 1000;
+    uint8_t i = 0;
+
+    while (i < program_entry_count && program_entries[i].at != at)
+    {
+        i++;
+    }
+
+    if (i == PROGRAM_SCHEDULE_SIZE)
+    {
+        return false;
+    }
+
+    program_entries[i].at = at;
+    program_entries[i].speed = speed;
+    program_entry_count += (i == program_entry_count) ? 1 : 0;
+    program_schedule_next(now);
+
+    return true;
+}
+
+void program_schedule_clear(void)
+{
+    program_entry_count = 0;
+    program_next_entry_at = UINT64_MAX;
+}
+
+//Time of day for the schedule, there is no RTC or SNTP
+bool program_set_clock(uint32_t hhmmss, uint64_t now)
+{
+    uint32_t hours = hhmmss / 10000;
+    uint32_t minutes = (hhmmss / 100) % 100;
+    uint32_t seconds = hhmmss % 100;
+
+    if (hours > 23 || minutes > 59 || seconds > 59)
+    {
+        return false;
+    }
+
+    program_clock_us = ((hours * 60ull + minutes) * 60 + seconds) * 1000 * 1000;
+    program_clock_set_at = now;
+    program_clock_valid = true;
+    program_schedule_next(now);
+
+    return true;
+}
+
+//Remaining time of a running program is pushed every seconds, counted from now
+void program_set_push_interval(uint32_t seconds, uint64_t now)
+{
+    program_push_us = (uint64_t)seconds * 1000 * 1000;
+
+    if (program_running())
+    {
+        program_next_push = (program_push_us > 0) ? now + program_push_us : UINT64_MAX;
+    }
+}
+
+//Runs the transitions that are due: returns the speed to switch to or PROGRAM_NO_SPEED, push is set
+//when the remaining time is to be published. A schedule entry during a program changes the speed it
+//reverts to, the program keeps running.
+int program_due(uint64_t now, bool* push)
+{
+    int speed = PROGRAM_NO_SPEED;
+
+    *push = program_push_end;
+    program_push_end = false;
+
+    while (program_next_entry_at <= now)
+    {
+        if (program_running())
+        {
+            program_revert_speed = program_entries[program_next_entry].speed;
+        }
+        else
+        {
+            speed = program_entries[program_next_entry].speed;
+        }
+        program_schedule_next(program_next_entry_at);
+    }
+
+    if (program_ends_at <= now)
+    {
+        speed = program_cancel();
+        program_push_end = false;
+        *push = true;
+    }
+    else if (program_next_push <= now)
+    {
+        program_next_push = (program_push_us > 0) ? now + program_push_us : UINT64_MAX;
+        *push = true;
+    }
+
+    return speed;
+}
+
+//Time of the next transition or push, UINT64_MAX when nothing is due
+uint64_t program_deadline(void)
+{
+    uint64_t deadline = program_next_entry_at;
+
+    if (program_ends_at < deadline)
+    {
+        deadline = program_ends_at;
+    }
+
+    if (program_next_push < deadline)
+    {
+        deadline = program_next_push;
+    }
+
+    return deadline;
+}
+
+//Zeroed first, two states of the same program and schedule compare equal with memcmp
+void program_get_state(program_state_t* state)
+{
+    memset(state, 0, sizeof(program_state_t));
+
+    state->ends_at = program_ends_at;
+    state->revert_speed = program_revert_speed;
+    state->push_seconds = program_push_us / (1000 * 1000);
+    state->schedule_count = program_entry_count;
+
+    for (uint8_t i = 0; i < program_entry_count; i++)
+    {
+        uint32_t minutes = program_entries[i].at / (60ull * 1000 * 1000);
+
+        state->schedule_hhmm[i] = (minutes / 60) * 100 + (minutes % 60);
+        state->schedule_speed[i] = program_entries[i].speed;
+    }
+}
+
+//A program continues with the time it had left, the schedule waits for the clock like after program_schedule
+void program_restore(const program_state_t* state, uint64_t now)
+{
+    program_initialize();
+    program_push_us = (uint64_t)state->push_seconds * 1000 * 1000;
+
+    if (state->ends_at != UINT64_MAX && state->revert_speed != PROGRAM_NO_SPEED)
+    {
+        program_ends_at = state->ends_at;
+        program_revert_speed = state->revert_speed;
+        program_next_push = now;
+    }
+
+    for (uint8_t i = 0; i < state->schedule_count && i < PROGRAM_SCHEDULE_SIZE; i++)
+    {
+        program_schedule(state->schedule_hhmm[i], state->schedule_speed[i], now);
+    }
+}
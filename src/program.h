@@ -0,0 +1,41 @@
+#ifndef E7B3C1A6_5D29_4F8E_B04A_3C6D8E1F2A97
+#define E7B3C1A6_5D29_4F8E_B04A_3C6D8E1F2A97
+#include <stdbool.h>
+#include <stdint.h>
+
+//Timed programs and the daily schedule of the speed. Nothing is polled: program_deadline is the next
+//transition or remaining time push, ventcontrol_task sleeps until then and program_due runs what is due.
+//A program runs a speed for some minutes and reverts to the speed before it. The schedule sets a speed
+//at a time of day, it waits for the clock to be set as the board has no time of day of its own.
+#define PROGRAM_SCHEDULE_SIZE   8       // schedule entries, one speed change each
+#define PROGRAM_PUSH_SECONDS    60      // default time between remaining time pushes, 0 pushes only at start and end
+#define PROGRAM_MAX_SPEED       3
+#define PROGRAM_NO_SPEED        -1
+
+//What is kept across a reboot: a program in progress, the push interval and the schedule
+typedef struct program_state_t
+{
+    uint64_t ends_at;                   //time_us_64 the program reverts, UINT64_MAX without one
+    int revert_speed;
+    uint32_t push_seconds;
+    uint8_t schedule_count;
+    uint16_t schedule_hhmm[PROGRAM_SCHEDULE_SIZE];
+    int8_t schedule_speed[PROGRAM_SCHEDULE_SIZE];
+} program_state_t;
+
+void program_initialize(void);
+void program_start(uint32_t minutes, int revert_speed, uint64_t now);
+int program_cancel(void);
+bool program_running(void);
+uint64_t program_ends(void);
+uint32_t program_remaining_seconds(uint64_t now);
+bool program_schedule(uint16_t hhmm, int speed, uint64_t now);
+void program_schedule_clear(void);
+bool program_set_clock(uint32_t hhmmss, uint64_t now);
+void program_set_push_interval(uint32_t seconds, uint64_t now);
+int program_due(uint64_t now, bool* push);
+uint64_t program_deadline(void);
+void program_get_state(program_state_t* state);
+void program_restore(const program_state_t* state, uint64_t now);
+
+#endif /* E7B3C1A6_5D29_4F8E_B04A_3C6D8E1F2A97 */
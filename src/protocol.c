@@ -0,0 +1,91 @@
+#include "protocol.h"
+
+//CRC-16/CCITT-FALSE without a table, a few shifts per byte on the M0+
+uint16_t protocol_crc16(const uint8_t* data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--)
+    {
+        uint8_t x = (crc >> 8) ^ *data++;
+        x ^= x >> 4;
+        crc = (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+    }
+
+    return crc;
+}
+
+//Returns the frame size, 0 when the items do not fit in size
+uint16_t protocol_encode(uint8_t* buf, uint16_t size, const protocol_item_t* items, uint8_t count)
+{
+    uint16_t payload = count * PROTOCOL_ITEM_SIZE;
+    uint16_t frame = PROTOCOL_HEADER_SIZE + payload + PROTOCOL_CRC_SIZE;
+
+    if (count == 0 || count > PROTOCOL_MAX_ITEMS || frame > size)
+    {
+        return 0;
+    }
+
+    uint8_t* p = buf;
+    *p++ = PROTOCOL_SYNC;
+    *p++ = payload;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint32_t value = (uint32_t)items[i].value;
+
+        *p++ = items[i].type;
+        *p++ = value >> 24;
+        *p++ = value >> 16;
+        *p++ = value >> 8;
+        *p++ = value;
+    }
+
+    uint16_t crc = protocol_crc16(buf + 1, 1 + payload);
+    *p++ = crc >> 8;
+    *p++ = crc;
+
+    return frame;
+}
+
+//Returns the frame size and fills items, PROTOCOL_INCOMPLETE or PROTOCOL_INVALID
+int16_t protocol_decode(const uint8_t* buf, uint16_t len, protocol_item_t* items, uint8_t* count)
+{
+    if (len < PROTOCOL_HEADER_SIZE)
+    {
+        return (len > 0 && buf[0] != PROTOCOL_SYNC) ? PROTOCOL_INVALID : PROTOCOL_INCOMPLETE;
+    }
+
+    uint8_t payload = buf[1];
+
+    if (buf[0] != PROTOCOL_SYNC || payload == 0 || payload % PROTOCOL_ITEM_SIZE != 0 ||
+        payload > PROTOCOL_MAX_ITEMS * PROTOCOL_ITEM_SIZE)
+    {
+        return PROTOCOL_INVALID;
+    }
+
+    uint16_t frame = PROTOCOL_HEADER_SIZE + payload + PROTOCOL_CRC_SIZE;
+
+    if (len < frame)
+    {
+        return PROTOCOL_INCOMPLETE;
+    }
+
+    uint16_t crc = ((uint16_t)buf[frame - 2] << 8) | buf[frame - 1];
+
+    if (protocol_crc16(buf + 1, 1 + payload) != crc)
+    {
+        return PROTOCOL_INVALID;
+    }
+
+    const uint8_t* p = buf + PROTOCOL_HEADER_SIZE;
+    *count = payload / PROTOCOL_ITEM_SIZE;
+
+    for (uint8_t i = 0; i < *count; i++, p += PROTOCOL_ITEM_SIZE)
+    {
+        items[i].type = p[0];
+        items[i].value = (int32_t)(((uint32_t)p[1] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 8) | p[4]);
+    }
+
+    return frame;
+}
@@ -0,0 +1,29 @@
+#ifndef C81F4D2A_7B36_4E95_A0C2_5F9E3B61D8A4
+#define C81F4D2A_7B36_4E95_A0C2_5F9E3B61D8A4
+#include <stdint.h>
+
+//Binary frames: sync, payload length, items, CRC-16/CCITT over length and items, big endian.
+//An item is a message type and a 32 bit value, a frame carries up to PROTOCOL_MAX_ITEMS of them.
+//A connection switches from text to binary with the text command BIN#, the server answers BIN#
+//and every byte after it in both directions is binary until the connection closes.
+#define PROTOCOL_SYNC           0xA5    // never the first byte of a text command
+#define PROTOCOL_HEADER_SIZE    2       // sync, length
+#define PROTOCOL_CRC_SIZE       2
+#define PROTOCOL_ITEM_SIZE      5       // type, value
+#define PROTOCOL_MAX_ITEMS      16
+#define PROTOCOL_MAX_FRAME      (PROTOCOL_HEADER_SIZE + PROTOCOL_MAX_ITEMS * PROTOCOL_ITEM_SIZE + PROTOCOL_CRC_SIZE)
+
+#define PROTOCOL_INCOMPLETE     0       // protocol_decode needs more bytes
+#define PROTOCOL_INVALID        -1      // bad sync, length or CRC; skip one byte and decode again
+
+typedef struct protocol_item_t
+{
+    uint8_t type;       //MSG_ type
+    int32_t value;
+} protocol_item_t;
+
+uint16_t protocol_crc16(const uint8_t* data, uint16_t len);
+uint16_t protocol_encode(uint8_t* buf, uint16_t size, const protocol_item_t* items, uint8_t count);
+int16_t protocol_decode(const uint8_t* buf, uint16_t len, protocol_item_t* items, uint8_t* count);
+
+#endif /* C81F4D2A_7B36_4E95_A0C2_5F9E3B61D8A4 */
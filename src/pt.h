@@ -0,0 +1,47 @@
+#ifndef E7C4A1D2_3B58_4F0E_9A61_5D2C8B7F4E19
+#define E7C4A1D2_3B58_4F0E_9A61_5D2C8B7F4E19
+#include <stdint.h>
+
+//Protothreads: stackless coroutines built on a switch over the line of the last wait.
+//A thread is a function that returns at every wait and continues there when it is called again.
+//Locals do not survive a wait, keep the state in the struct that owns the pt_t.
+//No switch statement may span a wait inside a thread.
+
+typedef struct pt_t
+{
+    uint16_t line;
+} pt_t;
+
+#define PT_WAITING  0
+#define PT_YIELDED  1
+#define PT_EXITED   2
+#define PT_ENDED    3
+
+#define PT_THREAD(declaration) char declaration
+
+#define PT_INIT(pt) ((pt)->line = 0)
+
+#define PT_BEGIN(pt) { char pt_yielded = 1; (void)pt_yielded; switch((pt)->line) { case 0:
+
+#define PT_END(pt) } pt_yielded = 0; PT_INIT(pt); return PT_ENDED; }
+
+//Return until condition is true, it is evaluated again on every call
+#define PT_WAIT_UNTIL(pt, condition)        \
+    do {                                    \
+        (pt)->line = __LINE__;              \
+        case __LINE__:                      \
+        if (!(condition)) return PT_WAITING;\
+    } while(0)
+
+//Return once, the thread continues after the yield on the next call
+#define PT_YIELD(pt)                        \
+    do {                                    \
+        pt_yielded = 0;                     \
+        (pt)->line = __LINE__;              \
+        case __LINE__:                      \
+        if (pt_yielded == 0) return PT_YIELDED;\
+    } while(0)
+
+#define PT_EXIT(pt) do { PT_INIT(pt); return PT_EXITED; } while(0)
+
+#endif /* E7C4A1D2_3B58_4F0E_9A61_5D2C8B7F4E19 */
@@ -1,7 +1,20 @@
 #include "server.h"
 #include "types.h"
+#include "pt.h"
+#include "protocol.h"
+#include "command.h"
+#include "latency.h"
+#include "tx_queue.h"
+#include "deadline_heap.h"
+#include "message_pool.h"
+#include "ventcontrol.h"
 #include "socket.h"
+#include "w5x00_socket.h"
+#include "w5x00_spi.h"
 #include "pico/stdlib.h"
+#include "w5x00_gpio_irq.h"
+#include "timer.h"
+#include "socket_memory.h"
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -13,21 +26,112 @@ typedef struct socket_data_t
     uint8_t socket_id;
     uint16_t listening_port;
     bool socket_open;
-    uint8_t receive_buffer[BUFFER_SIZE];
+    wizchip_socket_snapshot_t snapshot;
+    uint8_t receive_buffer[BUFFER_SIZE];    //Window on the W5x00 RX buffer
     uint16_t receive_size;
-    uint8_t send_buffer[BUFFER_SIZE];
-    uint16_t send_size;
+    uint16_t receive_consumed;
+    uint32_t received_at;                   //HOP_RECEIVED of the commands in the window
+    tx_queue_t tx_queue;                    //Frames waiting for room in the W5x00 TX buffer
     uint64_t last_command_received;
     uint64_t last_command_send;
+    uint64_t last_request;                  //Last command other than a heartbeat, the idlest client is evicted
+    pt_t pt;                                //Connection protothread
+    uint8_t wait;                           //SERVER_WAIT_ flags the connection waits for
+    uint8_t events;                         //SERVER_WAIT_ flags that resumed the connection
+    message_t* reply;                       //SERVER_WAIT_REPLY, borrowed from the caller of server_poll
+    bool binary;                            //Binary frames instead of text commands
+    protocol_item_t items[PROTOCOL_MAX_ITEMS];  //Items of the last binary frame
+    uint8_t item_count;
+    uint8_t item_next;
+    bool subscribed;                        //Speed changes are pushed to the client
+    bool publish_pending;                   //The latest publication is not in the send buffer yet
+    bool listening;                         //A new client can connect to this socket
+    bool evict;                             //Closed on the next resume to make room for a new client
+    uint32_t trace[HOP_COUNT];              //Hops of the last traced reply
+    bool trace_pending;                     //The traced reply is queued, its latency is recorded when it leaves
+    uint8_t in_flight;                      //Commands at the control tasks whose reply did not come back yet
 } socket_data_t;
 
-void server_loop(socket_data_t* socket_info);
+//The latest publication, serialized once for each protocol and copied to every subscriber
+typedef struct server_publication_t
+{
+    message_t* message;                     //Held until the next publication replaces it
+    uint8_t text[16];
+    uint8_t text_size;
+    uint8_t frame[PROTOCOL_HEADER_SIZE + PROTOCOL_ITEM_SIZE + PROTOCOL_CRC_SIZE];
+    uint8_t frame_size;
+} server_publication_t;
+
+//Admission of the connection pool, the W5x00 refuses a client while no socket listens
+typedef struct server_pool_t
+{
+    uint8_t listeners;                      //Listening sockets after the last poll
+    uint8_t clients;                        //Established connections after the last poll
+    uint8_t max_clients;
+    uint32_t accepts;
+    uint32_t evictions;
+    bool demand;                            //A new client took the last listener, an idle client makes room for the next
+    uint64_t full_since;                    //No listener since, 0 while one listens
+    uint64_t full_us;                       //Time without a listener, connects were refused
+} server_pool_t;
+
+static TaskHandle_t server_task_handle = NULL;
+static QueueHandle_t server_receive_queue = NULL;
+static socket_data_t socket_data[LISTENING_SOCKET_COUNT];
+static uint8_t socket_mask = 0;
+static server_deliver_t server_deliver = NULL;
+static uint32_t server_resumes = 0;
+static server_publication_t server_publication;
+static uint32_t server_conflated = 0;
+static uint32_t server_state_reads = 0;         //Status requests answered from the state snapshot
+static uint32_t server_state_retries = 0;       //Snapshot reads that overlapped a write of ventcontrol_task
+static server_pool_t server_pool;
+static deadline_heap_t server_deadlines;       //SERVER_WAIT_TIMER of the connections, by index in socket_data
+
+#if LISTENING_SOCKET_COUNT > DEADLINE_HEAP_SIZE
+#error "Every listening socket needs a place in the deadline heap"
+#endif
+
+static PT_THREAD(server_connection(socket_data_t* socket_info));
+bool server_serve(socket_data_t* socket_info);
 bool handle_receive_bufffer(socket_data_t* socket_info, message_t* message);
+void server_consume(socket_data_t* socket_info);
+void server_spi_stats(socket_data_t* socket_info);
+void server_latency(socket_data_t* socket_info);
+void server_send_item(socket_data_t* socket_info, uint8_t type, int32_t value);
+void server_publish(message_t* message);
+bool server_deliver_message(socket_data_t* socket_info, const message_t* received_message);
+bool server_answer_state(socket_data_t* socket_info, const message_t* received_message);
+void server_queue(socket_data_t* socket_info, const uint8_t* frame, uint16_t len);
+int32_t server_flush(socket_data_t* socket_info);
+void server_accepted(socket_data_t* socket_info);
+void server_admit(uint64_t now, uint64_t* next_poll);
+
+//Called from the W5x00 INT pin interrupt
+static void server_interrupt_callback(void)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if (server_task_handle != NULL)
+    {
+        vTaskNotifyGiveFromISR(server_task_handle, &higher_priority_task_woken);
+    }
+
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+static bool server_queue_message(message_t* message)
+{
+    return xQueueSend(server_receive_queue, (void *)&message, 10) == pdTRUE;
+}
 
 void server_task(void* params)
 {
     server_data_t* server_data = (server_data_t*) params;
-    socket_data_t socket_data[LISTENING_SOCKET_COUNT];
+
+    server_task_handle = xTaskGetCurrentTaskHandle();
+    server_data->server_task = server_task_handle;
+    server_receive_queue = server_data->receive_queue;
 
     while(true)
     {
@@ -35,258 +139,959 @@ void server_task(void* params)
         xSemaphoreTake(server_data->ip_assigned_sem, portMAX_DELAY);
         printf("IP Assigned, starting tcp server.\n");
 
-        //Initialise socket data
-        for(int i = 0; i < LISTENING_SOCKET_COUNT; ++i)
-        {
-            socket_data[i].socket_id = BASE_PORT_ID + i;
-            socket_data[i].listening_port = LISTENING_PORT;
-            socket_data[i].socket_open = false;
-            socket_data[i].receive_size = 0;
-            socket_data[i].send_size = 0;
+        //Connect, disconnect, receive and timeout of the listening sockets wake up this task
+        server_start(server_interrupt_callback);
 
-            socket(socket_data[i].socket_id, Sn_MR_TCP, socket_data[i].listening_port, 0x0);
-            server_loop(&socket_data[i]);
-        }
+        TickType_t last_sweep = xTaskGetTickCount();
+        uint64_t next_poll = time_us_64();
 
         while(server_data->server_run)
         {
-            message_t send_message;
-            send_message.message_type = NO_MESSAGE;
-
-            xQueueReceive(server_data->send_queue, (void *)&send_message,  ( TickType_t ) 100);
+            message_t* send_message = NULL;
 
-            for(int i = 0; i < LISTENING_SOCKET_COUNT; ++i)
+            //Sleep until a W5x00 interrupt, a reply, the earliest deadline of the connections or the next sweep
+            if (xQueueReceive(server_data->send_queue, (void *)&send_message, 0) != pdTRUE)
             {
-                //If the socket is open, check if we need to send a command or heartbeat
-                if (socket_data[i].socket_open)
+                TickType_t since_sweep = xTaskGetTickCount() - last_sweep;
+                TickType_t wait_ticks = (since_sweep < SERVER_SWEEP_TICKS) ? (SERVER_SWEEP_TICKS - since_sweep) : 0;
+                uint64_t now = time_us_64();
+
+                //Without a memory profile to apply and without clients the task sleeps until a W5x00 interrupt
+                if (!server_sweep_pending())
                 {
-                    //If the message is for this socket
-                    if (send_message.client == socket_data[i].socket_id)
-                    {
-                        if (send_message.message_type != NO_MESSAGE)
-                        {
-                            if (send_message.message_type == MSG_CURRENT_SPEEED)
-                            {
-                                socket_data[i].send_size = sprintf((char*)socket_data[i].send_buffer, "S%d#", send_message.value);
-                            }
-                            if (send_message.message_type == MSG_REMAINING_TIME)
-                            {
-                                socket_data[i].send_size = sprintf((char*)socket_data[i].send_buffer, "T%d#", send_message.value);
-                            }
-                        }
-                    }
-
-                    //No need to send data, check if we need to send a heartbeat
-                    if (socket_data[i].send_size == 0)
-                    {
-                        uint64_t now = time_us_64();
-                        uint64_t last_command_send_time = (now - socket_data[i].last_command_send);
-
-                        if (last_command_send_time  > (KEEP_ALIVE_SECONDS * 1000 * 1000))
-                        {
-                            printf("[%d]: Sending heartbeat.\n",i);
-                            socket_data[i].send_size = sprintf((char*)socket_data[i].send_buffer, "HB#", send_message.value);
-                        }
-                    }
+                    wait_ticks = portMAX_DELAY;
                 }
 
-                server_loop(&socket_data[i]);
-
-                message_t received_message;
-                //Check for received TCP messages
-                while(handle_receive_bufffer(&socket_data[i], &received_message))
+                if (next_poll <= now)
                 {
-                    if (received_message.message_type != MSG_KEEPALIVE && received_message.message_type != NO_MESSAGE)
-                    {
-                        printf("Message received from tcp client: %d, message_type: %d\n", received_message.client, received_message.message_type);
-                        if (xQueueSend(server_data->receive_queue, (void *)&received_message, 10) != pdTRUE) {
-                            printf("\nUnable to put message on receive_queue\n");
-                        }
-                    }
+                    wait_ticks = 0;
                 }
+                else if ((next_poll - now) < ((uint64_t)wait_ticks * portTICK_PERIOD_MS * 1000))
+                {
+                    //Round up, a deadline is never handled early
+                    wait_ticks = (TickType_t)((next_poll - now + (portTICK_PERIOD_MS * 1000) - 1) / (portTICK_PERIOD_MS * 1000));
+                }
+
+                ulTaskNotifyTake(pdTRUE, wait_ticks);
+                xQueueReceive(server_data->send_queue, (void *)&send_message, 0);
+            }
+
+            bool sweep = (xTaskGetTickCount() - last_sweep) >= SERVER_SWEEP_TICKS;
+            if (sweep)
+            {
+                last_sweep = xTaskGetTickCount();
             }
+
+            next_poll = server_poll(send_message, sweep, server_queue_message);
+            message_release(send_message);
         }
 
+        server_stop();
+
         printf("\nTcp server stopping\n");
     }
 }
 
-void server_loop(socket_data_t* socket_info)
+void server_start(void (*interrupt_callback)(void))
 {
-    long ret = 0;
-    uint16_t size = 0;
+    //The pool claims every socket but the DHCP socket, partition the socket memory for it before the listeners open
+    socket_mask = 0;
+    for(int i = 0, sn = 0; i < LISTENING_SOCKET_COUNT && sn < _WIZCHIP_SOCK_NUM_; ++sn)
+    {
+        if (sn == SOCKET_MEMORY_DHCP_SOCKET)
+        {
+            continue;
+        }
+
+        close(sn);
+        socket_mask |= (1 << sn);
+        socket_data[i++].socket_id = sn;
+    }
+    socket_memory_apply(socket_mask);
+    command_initialize();
+    memset(&server_pool, 0, sizeof(server_pool));
+    deadline_heap_reset(&server_deadlines);
 
-    switch(getSn_SR(socket_info->socket_id))
+    //Initialise socket data, each connection runs until it listens
+    for(int i = 0; i < LISTENING_SOCKET_COUNT; ++i)
     {
-        case SOCK_ESTABLISHED :
-            {
-                if (!socket_info->socket_open)
-                {
-                    socket_info->socket_open = true;
-                    socket_info->last_command_received = time_us_64();
-                    socket_info->last_command_send = time_us_64();
+        socket_data[i].listening_port = LISTENING_PORT;
+        socket_data[i].socket_open = false;
+        socket_data[i].events = 0;
+        PT_INIT(&socket_data[i].pt);
 
-                    printf("[%d]: SOCK_ESTABLISHED\n",socket_info->socket_id);
-                }
+        server_connection(&socket_data[i]);
+    }
+
+    wizchip_gpio_interrupt_initialize_mask(socket_mask, interrupt_callback);
+}
+
+//Resumes the connections that have an event they wait for,
+//returns the time of the earliest deadline or SENDOK poll of all connections, UINT64_MAX when there is none
+//send_message may be NULL and stays with the caller, a publication is a pool block held until the next one
+uint64_t server_poll(message_t* send_message, bool sweep, server_deliver_t deliver)
+{
+    uint64_t next_poll = UINT64_MAX;
+
+#ifdef SERVER_SPI_STATS
+    static uint32_t stats_loops = 0;
+    static uint32_t stats_transactions = 0;
+    static uint32_t stats_resumes = 0;
+    static uint64_t stats_start = 0;
+#endif
+
+    if (sweep)
+    {
+        //A queued memory profile waits until no client holds a socket whose buffer moves
+        if (socket_memory_pending())
+        {
+            socket_memory_apply(socket_mask);
+        }
+    }
+
+    server_deliver = deliver;
+
+    bool send = (send_message != NULL) && (send_message->message_type != NO_MESSAGE);
+    bool publish = send && (send_message->client == MESSAGE_CLIENT_ALL);
+    if (publish)
+    {
+        server_publish(send_message);
+    }
+
+    uint8_t interrupts = getSIR();
+    uint64_t now = time_us_64();
+    uint32_t timers = 0;
+    uint8_t expired;
+
+
+    //Only the connections whose deadline passed, the others are not looked at
+    while (deadline_heap_expired(&server_deadlines, now, &expired))
+    {
+        timers |= (1u << expired);
+    }
+
+    for(int i = 0; i < LISTENING_SOCKET_COUNT; ++i)
+    {
+        socket_data_t* socket_info = &socket_data[i];
+        uint8_t events = 0;
+
+        if (interrupts & (1 << socket_info->socket_id))
+        {
+            //Clear before reading the socket, events after this point raise a new interrupt
+            setSn_IR(socket_info->socket_id, SERVER_SOCKET_INTERRUPTS);
+            events |= SERVER_WAIT_SOCKET;
+        }
+
+        //Read in place while the connection runs, the caller holds the message
+        if (send && (send_message->client == socket_info->socket_id))
+        {
+            socket_info->reply = send_message;
+            latency_stamp(send_message, HOP_REPLY_TAKEN);
+            events |= SERVER_WAIT_REPLY;
+        }
+
+        //Latest value wins: a subscriber that has not sent the previous publication skips it
+        if (publish && socket_info->subscribed)
+        {
+            server_conflated += socket_info->publish_pending ? 1 : 0;
+            socket_info->publish_pending = true;
+            events |= SERVER_WAIT_PUBLISH;
+        }
+
+        if (timers & (1u << i))
+        {
+            events |= SERVER_WAIT_TIMER;
+        }
+
+        //SENDOK has no interrupt, a connection waiting for it is resumed on every poll
+        events |= SERVER_WAIT_WRITABLE;
+
+        //Events a connection does not wait for are dropped, like a reply for a client that left
+        if (events & socket_info->wait)
+        {
+            socket_info->events = events & socket_info->wait;
+            server_connection(socket_info);
+            server_resumes++;
+        }
+
+        socket_info->reply = NULL;
+
+        if ((socket_info->wait & SERVER_WAIT_WRITABLE) && ((now + SERVER_SEND_RETRY_US) < next_poll))
+        {
+            next_poll = now + SERVER_SEND_RETRY_US;
+        }
+    }
+
+    //Deadlines set while the connections ran, the heap holds the earliest at its root
+    if (deadline_heap_next(&server_deadlines) < next_poll)
+    {
+        next_poll = deadline_heap_next(&server_deadlines);
+    }
+
+    server_admit(now, &next_poll);
+
+    //An event after the read of SIR keeps the INT pin low without a new edge, poll again right away.
+    //The pin level costs no SPI transaction.
+    if (wizchip_gpio_interrupt_pending())
+    {
+        next_poll = now;
+    }
+
+#ifdef SERVER_SPI_STATS
+    stats_loops++;
+    if ((time_us_64() - stats_start) > (SERVER_SPI_STATS_SECONDS * 1000 * 1000))
+    {
+        uint32_t transactions = wizchip_spi_get_transaction_count();
+        printf("SPI transactions per server loop: %ld (%ld loops, %ld connections resumed, %ld publications conflated)\n",
+               (transactions - stats_transactions) / stats_loops, stats_loops, server_resumes - stats_resumes, server_conflated);
+        printf("Longest W5x00 bus hold: %ld us, longest interrupt masking: %ld us (W5x00 lock), %ld us (timer latency)\n",
+               wizchip_spi_get_max_bus_hold_us(), wizchip_spi_get_max_masked_us(), wizchip_1ms_timer_get_max_latency_us());
+        socket_memory_print_stats();
+        printf("Connection pool: %d clients (max %d), %d listening, %ld accepts, %ld evictions, "
+               "%ld ms without a listener\n", server_pool.clients, server_pool.max_clients, server_pool.listeners,
+               server_pool.accepts, server_pool.evictions, (long)(server_pool.full_us / 1000));
+        latency_print_stats();
+        message_pool_print_stats();
+        printf("State snapshot: %ld status requests answered without the queues, %ld reads tried again\n",
+               server_state_reads, server_state_retries);
+
+        //Coalescing: frames per SEND command, above 1 when replies, publications and heartbeats share one
+        for(int i = 0; i < LISTENING_SOCKET_COUNT; ++i)
+        {
+            tx_queue_t* queue = &socket_data[i].tx_queue;
+            uint32_t sends = queue->sends ? queue->sends : 1;
+
+            printf("[%d]: TX queue %d bytes (max %d), %ld frames in %ld sends, %ld.%02ld frames per send, %ld dropped\n",
+                   socket_data[i].socket_id, tx_queue_depth(queue), queue->max_depth, queue->frames, queue->sends,
+                   queue->frames / sends, (queue->frames % sends) * 100 / sends, queue->dropped);
+        }
+
+        stats_loops = 0;
+        stats_transactions = transactions;
+        stats_resumes = server_resumes;
+        stats_start = time_us_64();
+    }
+#endif
+
+    return next_poll;
+}
+
+void server_stop(void)
+{
+    //No wake ups while the server is stopped
+    wizchip_gpio_interrupt_initialize_mask(0, NULL);
+    socket_mask = 0;
+    deadline_heap_reset(&server_deadlines);
+
+    message_release(server_publication.message);
+    server_publication.message = NULL;
+}
+
+//A memory profile waits to be applied by a sweep
+bool server_sweep_pending(void)
+{
+    return socket_memory_pending();
+}
+
+//Park a connection until one of the wait flags is set by the scheduler
+static void server_wait(socket_data_t* socket_info, uint8_t wait, uint64_t deadline)
+{
+    uint8_t owner = socket_info - socket_data;
+
+    socket_info->wait = wait;
+    socket_info->events = 0;
+
+    if (wait & SERVER_WAIT_TIMER)
+    {
+        deadline_heap_set(&server_deadlines, owner, deadline);
+    }
+    else
+    {
+        deadline_heap_cancel(&server_deadlines, owner);
+    }
+}
+
+//The timeout, and the heartbeat when nothing waits to be sent or the stall check when something does
+static uint64_t server_deadline(const socket_data_t* socket_info)
+{
+    uint64_t timeout = socket_info->last_command_received + (TIMEOUT_SECONDS * 1000 * 1000);
+    uint64_t heartbeat = socket_info->last_command_send + (KEEP_ALIVE_SECONDS * 1000 * 1000);
+    uint64_t stall = socket_info->last_command_send + (TIMEOUT_SECONDS * 1000 * 1000);
+
+    if (!tx_queue_empty(&socket_info->tx_queue))
+    {
+        return (stall < timeout) ? stall : timeout;
+    }
+
+    return (heartbeat < timeout) ? heartbeat : timeout;
+}
+
+//The life of one connection: listen, serve the client until it leaves or times out, close, listen again
+static PT_THREAD(server_connection(socket_data_t* socket_info))
+{
+    PT_BEGIN(&socket_info->pt);
+
+    while (true)
+    {
+        socket_info->socket_open = false;
+        tx_queue_reset(&socket_info->tx_queue);
+        socket_info->receive_size = 0;
+        socket_info->receive_consumed = 0;
+        socket_info->binary = false;
+        socket_info->item_count = 0;
+        socket_info->item_next = 0;
+        socket_info->subscribed = false;
+        socket_info->publish_pending = false;
+        socket_info->listening = false;
+        socket_info->evict = false;
+        socket_info->trace_pending = false;
+        socket_info->in_flight = 0;
+        wizchip_socket_reset(socket_info->socket_id);
+
+        if (socket(socket_info->socket_id, Sn_MR_TCP, socket_info->listening_port, 0x0) != socket_info->socket_id ||
+            listen(socket_info->socket_id) != SOCK_OK)
+        {
+            close(socket_info->socket_id);
+            server_wait(socket_info, SERVER_WAIT_TIMER, time_us_64() + SERVER_OPEN_RETRY_US);
+            PT_YIELD(&socket_info->pt);
+            continue;
+        }
+
+        printf("[%d]: SOCK_LISTEN\n",socket_info->socket_id);
+        socket_info->listening = true;
+
+        //Readable: a client connects, or connects and leaves before we look
+        do
+        {
+            server_wait(socket_info, SERVER_WAIT_SOCKET, 0);
+            PT_YIELD(&socket_info->pt);
+
+            wizchip_socket_snapshot(socket_info->socket_id, &socket_info->snapshot);
+        } while (socket_info->snapshot.status == SOCK_LISTEN || socket_info->snapshot.status == SOCK_SYNRECV);
+
+        socket_info->listening = false;
+
+        if (socket_info->snapshot.status == SOCK_ESTABLISHED)
+        {
+            socket_info->socket_open = true;
+            socket_info->last_command_received = time_us_64();
+            socket_info->last_command_send = time_us_64();
+            socket_info->last_request = socket_info->last_command_received;
+
+            printf("[%d]: SOCK_ESTABLISHED\n",socket_info->socket_id);
+            server_accepted(socket_info);
+
+            //Readable, writable while a send waits for SENDOK, a reply, or the heartbeat and timeout deadline
+            while (server_serve(socket_info))
+            {
+                server_wait(socket_info,
+                            SERVER_WAIT_SOCKET | SERVER_WAIT_REPLY | SERVER_WAIT_PUBLISH | SERVER_WAIT_TIMER |
+                            (!tx_queue_empty(&socket_info->tx_queue) ? SERVER_WAIT_WRITABLE : 0),
+                            server_deadline(socket_info));
+                PT_YIELD(&socket_info->pt);
             }
+        }
+
+        socket_info->socket_open = false;
 
-            if((size = getSn_RX_RSR(socket_info->socket_id)) > 0) // Don't need to check SOCKERR_BUSY because it doesn't not occur.
+        if (socket_info->snapshot.status == SOCK_CLOSE_WAIT)
+        {
+            printf("[%d]: SOCK_CLOSE_WAIT\n",socket_info->socket_id);
+            disconnect(socket_info->socket_id);
+        }
+
+        close(socket_info->socket_id);
+        printf("[%d]: SOCK_CLOSED\n",socket_info->socket_id);
+    }
+
+    PT_END(&socket_info->pt);
+}
+
+//One pass over an established connection, returns false when the connection ended
+bool server_serve(socket_data_t* socket_info)
+{
+    long ret = 0;
+    uint64_t now = time_us_64();
+    wizchip_socket_snapshot_t* snapshot = &socket_info->snapshot;
+
+    // One burst for status, sizes and pointers instead of a transaction per register
+    wizchip_socket_snapshot(socket_info->socket_id, snapshot);
+
+    if (snapshot->status != SOCK_ESTABLISHED)
+    {
+        return false;
+    }
+
+    if (socket_info->evict)
+    {
+        printf("[%d]: Evicted after %ld ms without a command, the pool had no listener left.\n",
+               socket_info->socket_id, (long)((now - socket_info->last_request) / 1000));
+        return false;
+    }
+
+    //Data that still waits for room in the TX buffer, a publication waits behind it
+    bool blocked = !tx_queue_empty(&socket_info->tx_queue);
+
+    if (socket_info->events & SERVER_WAIT_REPLY)
+    {
+        const message_t* reply = socket_info->reply;
+
+        socket_info->in_flight -= (socket_info->in_flight > 0) ? 1 : 0;
+
+        if (reply->message_type == MSG_CURRENT_SPEEED || reply->message_type == MSG_REMAINING_TIME)
+        {
+            server_send_item(socket_info, reply->message_type, reply->value);
+
+            if (latency_traced(reply))
             {
+                memcpy(socket_info->trace, reply->hops, sizeof(socket_info->trace));
+                socket_info->trace_pending = true;
+            }
+        }
+    }
 
-                memset(socket_info->receive_buffer + socket_info->receive_size, 0, BUFFER_SIZE);
+    if(snapshot->rx_received_size > socket_info->receive_size)
+    {
+        //Parse in place: the window mirrors the start of the W5x00 RX buffer, only bytes
+        //behind an incomplete command are read, nothing is released until server_consume
+        socket_info->receive_size += wizchip_socket_peek(socket_info->socket_id, snapshot, socket_info->receive_size,
+                                                         socket_info->receive_buffer + socket_info->receive_size,
+                                                         BUFFER_SIZE - socket_info->receive_size);
+        socket_info->receive_consumed = 0;
+        socket_info->last_command_received = now;
+        socket_info->received_at = latency_timestamp(now);
+    }
 
-                ret = recv(socket_info->socket_id, socket_info->receive_buffer, size);
-                if(ret != size)
-                {
-                    printf("[%d]: Received size is not equal to read size. Closing socket.\n",socket_info->socket_id);
-                    if(ret == SOCK_BUSY) return;// 0;
-                    if(ret < 0)
-                    {
-                        socket_info->socket_open = false;
-                        close(socket_info->socket_id);
-                        return;// ret;
-                    }
-                }
-                else
-                {
-                    socket_info->receive_size += size;
-                    socket_info->last_command_received = time_us_64();
-                }
+    message_t received_message;
+    //Check for received TCP messages
+    while(handle_receive_bufffer(socket_info, &received_message))
+    {
+        //A heartbeat only keeps the connection, it does not keep a client from being evicted
+        if (received_message.message_type != MSG_KEEPALIVE && received_message.message_type != NO_MESSAGE)
+        {
+            socket_info->last_request = now;
+        }
+
+        if (received_message.message_type == MSG_SPI_STATS)
+        {
+            //Answered by the server, it owns the W5x00
+            server_spi_stats(socket_info);
+        }
+        else if (received_message.message_type == MSG_LATENCY)
+        {
+            server_latency(socket_info);
+        }
+        else if (received_message.message_type == MSG_MEMORY_PROFILE)
+        {
+            //Applied at once when no client holds a socket whose buffer moves, the requester included.
+            //Otherwise it is queued and a sweep applies it once those clients disconnected.
+            if (!socket_memory_select(received_message.value))
+            {
+                server_send_item(socket_info, MSG_MEMORY_PROFILE, -1);
+            }
+            else if (socket_memory_apply(socket_mask) == SOCKET_MEMORY_OK)
+            {
+                server_send_item(socket_info, MSG_MEMORY_PROFILE, received_message.value);
             }
             else
             {
-                uint64_t now = time_us_64();
-                uint64_t last_command_received_time = (now - socket_info->last_command_received);
-
-                if (last_command_received_time  > (TIMEOUT_SECONDS * 1000 * 1000))
-                {
-                    //Close the connection when no data received in the last 15 seconds
-                    printf("[%d]: Closing due to timeout.\n",socket_info->socket_id);
-                    socket_info->socket_open = false;
-                    close(socket_info->socket_id);
-                    return;
-                }
+                server_send_item(socket_info, MSG_MEMORY_QUEUED, received_message.value);
             }
+        }
+        else if (received_message.message_type == MSG_SUBSCRIBE)
+        {
+            socket_info->subscribed = (received_message.value != 0);
 
-            if (socket_info->send_size > 0)
+            //A new subscriber gets the current state as the reply to a status request
+            if (socket_info->subscribed)
             {
-                ret = send(socket_info->socket_id, socket_info->send_buffer, socket_info->send_size);
-                socket_info->send_size = 0;
-                socket_info->last_command_send = time_us_64();
-
-                if(ret < 0)
+                received_message.message_type = MSG_GET_STATUS;
+                received_message.value = 0;
+                if (!server_answer_state(socket_info, &received_message))
                 {
-                    socket_info->socket_open = false;
-                    close(socket_info->socket_id);
-                    return;
+                    server_deliver_message(socket_info, &received_message);
                 }
             }
+        }
+        else if (received_message.message_type == MSG_BINARY)
+        {
+            //Acknowledged in text, the bytes after BIN# are frames
+            if (!socket_info->binary)
+            {
+                server_queue(socket_info, (const uint8_t*)"BIN#", 4);
+            }
+            socket_info->binary = true;
+        }
+        else if (received_message.message_type != MSG_KEEPALIVE && received_message.message_type != NO_MESSAGE &&
+                 !server_answer_state(socket_info, &received_message))
+        {
+            printf("Message received from tcp client: %d, message_type: %d\n", received_message.client, received_message.message_type);
+            server_deliver_message(socket_info, &received_message);
+        }
+    }
+    server_consume(socket_info);
 
-            break;
+    //A client that does not read gets only the latest publication once it reads again
+    if (socket_info->publish_pending && !blocked)
+    {
+        const uint8_t* data = socket_info->binary ? server_publication.frame : server_publication.text;
+        uint8_t size = socket_info->binary ? server_publication.frame_size : server_publication.text_size;
 
-        case SOCK_CLOSE_WAIT :
-            printf("[%d]: SOCK_CLOSE_WAIT\n",socket_info->socket_id);
-            ret=disconnect(socket_info->socket_id);
+        socket_info->publish_pending = !tx_queue_put(&socket_info->tx_queue, data, size);
+    }
 
-            if(ret != SOCK_OK)
-            {
-                return;
-            }
+    //No need to send data, check if we need to send a heartbeat
+    if (tx_queue_empty(&socket_info->tx_queue) && (now - socket_info->last_command_send) >= (KEEP_ALIVE_SECONDS * 1000 * 1000))
+    {
+        printf("[%d]: Sending heartbeat.\n",socket_info->socket_id);
+        server_send_item(socket_info, MSG_KEEPALIVE, 0);
+    }
+
+    //An incomplete command left in the W5x00 does not count as received data
+    if ((now - socket_info->last_command_received) >= (TIMEOUT_SECONDS * 1000 * 1000))
+    {
+        //Close the connection when no data received in the last 30 seconds
+        printf("[%d]: Closing due to timeout.\n",socket_info->socket_id);
+        return false;
+    }
 
-            socket_info->socket_open = false;
-            break;
+    if (!tx_queue_empty(&socket_info->tx_queue))
+    {
+        ret = server_flush(socket_info);
+        if (ret < 0)
+        {
+            return false;
+        }
 
-        case SOCK_CLOSED :
-            printf("[%d]: SOCK_CLOSED\n",socket_info->socket_id);
-            if((ret=socket(socket_info->socket_id, Sn_MR_TCP, socket_info->listening_port, 0x0)) != socket_info->socket_id)
+        // Previous send not finished or no room in the TX buffer, the connection waits until writable
+        if (ret == SOCK_BUSY)
+        {
+            //A client that stopped reading for as long as the receive timeout is closed
+            if ((now - socket_info->last_command_send) >= (TIMEOUT_SECONDS * 1000 * 1000))
             {
-                socket_info->socket_open = false;
-                close(socket_info->socket_id);
-                return;
+                printf("[%d]: Closing, client stopped reading.\n",socket_info->socket_id);
+                return false;
             }
-            break;
+            return true;
+        }
 
-        case SOCK_INIT :
-            printf("[%d]: SOCK_INIT\n",socket_info->socket_id);
-            socket_info->send_size = 0;
-            socket_info->receive_size = 0;
+        socket_info->last_command_send = now;
+    }
 
-            if( (ret = listen(socket_info->socket_id)) != SOCK_OK)
-            {
-                return;
-            }
+    return true;
+}
 
-            break;
+//A command for the control tasks, copied once into a pool block that travels by pointer from here on
+bool server_deliver_message(socket_data_t* socket_info, const message_t* received_message)
+{
+    message_t* message = message_alloc();
+
+    if (message == NULL)
+    {
+        printf("\nNo message block for the receive_queue\n");
+        return false;
+    }
+
+    *message = *received_message;
+    latency_stamp(message, HOP_DELIVERED);
 
-        default :
-            break;
+    if (!server_deliver(message))
+    {
+        message_release(message);
+        printf("\nUnable to put message on receive_queue\n");
+        return false;
     }
+
+    socket_info->in_flight++;
+
+    return true;
+}
+
+//Status and remaining time from the state snapshot of ventcontrol_task, no queue round trip and no task switch.
+//A client with commands still at the control tasks goes through the queue, its replies stay in order.
+bool server_answer_state(socket_data_t* socket_info, const message_t* received_message)
+{
+#ifdef SERVER_GET_QUEUED
+    return false;
+#else
+    vent_state_t state;
+    uint64_t now = time_us_64();
+
+    if ((received_message->message_type != MSG_GET_STATUS && received_message->message_type != MSG_REMAINING_TIME) ||
+        socket_info->in_flight > 0)
+    {
+        return false;
+    }
+
+    server_state_retries += ventcontrol_read_state(&state);
+    server_state_reads++;
+
+    if (received_message->message_type == MSG_GET_STATUS)
+    {
+        server_send_item(socket_info, MSG_CURRENT_SPEEED, state.speed);
+    }
+    else
+    {
+        uint32_t remaining = 0;
+
+        //Rounded up like ventcontrol_task does, 0 without a program
+        if (state.program_ends_at != UINT64_MAX && state.program_ends_at > now)
+        {
+            remaining = (state.program_ends_at - now + (1000 * 1000) - 1) / (1000 * 1000);
+        }
+        server_send_item(socket_info, MSG_REMAINING_TIME, remaining);
+    }
+
+    return true;
+#endif
 }
 
 bool handle_receive_bufffer(socket_data_t* socket_info, message_t* message)
 {
-    char *end  = strnstr((char*)socket_info->receive_buffer , "#", socket_info->receive_size);
-    if (end)
+    while (socket_info->item_next < socket_info->item_count || socket_info->receive_consumed < socket_info->receive_size)
     {
-        *end = 0;
-        if (!strcmp((char*)socket_info->receive_buffer, "GET"))
+        //The items of a binary frame are handed out one by one, replies are not accepted from clients
+        if (socket_info->item_next < socket_info->item_count)
         {
-            message->message_type = MSG_GET_STATUS;
-            message->client = socket_info->socket_id;
-            message->value = 0;
+            protocol_item_t* item = &socket_info->items[socket_info->item_next++];
 
-            socket_info->receive_size = 0;
-            return true;
+            if (item->type == MSG_GET_STATUS || item->type == MSG_SET_SPEED || item->type == MSG_KEEPALIVE ||
+                item->type == MSG_SPI_STATS || item->type == MSG_SUBSCRIBE || item->type == MSG_LATENCY ||
+                item->type == MSG_REMAINING_TIME || item->type == MSG_PROGRAM || item->type == MSG_SCHEDULE ||
+                item->type == MSG_CLOCK || item->type == MSG_PUSH_INTERVAL || item->type == MSG_MEMORY_PROFILE)
+            {
+                message->message_type = item->type;
+                message->client = socket_info->socket_id;
+                message->value = item->value;
+                memset(message->hops, 0, sizeof(message->hops));
+                message->hops[HOP_RECEIVED] = socket_info->received_at;
+
+                return true;
+            }
+            continue;
         }
-        if (!strcmp((char*)socket_info->receive_buffer, "SET0"))
+
+        if (socket_info->binary)
         {
-            message->message_type = MSG_SET_SPEED;
-            message->client = socket_info->socket_id;
-            message->value = 0;
+            int16_t frame = protocol_decode(socket_info->receive_buffer + socket_info->receive_consumed,
+                                            socket_info->receive_size - socket_info->receive_consumed,
+                                            socket_info->items, &socket_info->item_count);
 
-            socket_info->receive_size = 0;
-            return true;
+            //A frame always fits in the window, wait for the rest of it
+            if (frame == PROTOCOL_INCOMPLETE)
+            {
+                return false;
+            }
+
+            //Skip a byte until the next sync byte that starts a valid frame
+            if (frame == PROTOCOL_INVALID)
+            {
+                socket_info->receive_consumed++;
+                continue;
+            }
+
+            socket_info->receive_consumed += frame;
+            socket_info->item_next = 0;
+            continue;
         }
-        if (!strcmp((char*)socket_info->receive_buffer, "SET1"))
-        {
-            message->message_type = MSG_SET_SPEED;
-            message->client = socket_info->socket_id;
-            message->value = 1;
 
-            socket_info->receive_size = 0;
-            return true;
+        const command_t* command;
+        int32_t value;
+
+        //Every complete command in the window, an incomplete one stays for the next segment
+        if (!command_next(socket_info->receive_buffer, socket_info->receive_size, BUFFER_SIZE,
+                          &socket_info->receive_consumed, &command, &value))
+        {
+            return false;
         }
-        if (!strcmp((char*)socket_info->receive_buffer, "SET2"))
+
+        message->message_type = command->message_type;
+        message->client = socket_info->socket_id;
+        message->value = value;
+        memset(message->hops, 0, sizeof(message->hops));
+        message->hops[HOP_RECEIVED] = socket_info->received_at;
+
+        return true;
+    }
+
+    return false;
+}
+
+//Release the bytes of all parsed commands in the W5x00, an incomplete command stays in the window
+void server_consume(socket_data_t* socket_info)
+{
+    if (socket_info->receive_consumed > 0)
+    {
+        wizchip_socket_consume(socket_info->socket_id, &socket_info->snapshot, socket_info->receive_consumed);
+
+        socket_info->receive_size -= socket_info->receive_consumed;
+        memmove(socket_info->receive_buffer, socket_info->receive_buffer + socket_info->receive_consumed, socket_info->receive_size);
+    }
+
+    socket_info->receive_consumed = 0;
+}
+
+//Reply SPI<register transactions, bytes read, bytes written, longest us>,<same for socket buffers>,
+//<single byte calls>,<burst calls>,<lock held us>,<longest lock us>#, or one frame of MSG_SPI_STATS items in this order
+void server_spi_stats(socket_data_t* socket_info)
+{
+    wizchip_spi_stats_t stats;
+    wizchip_spi_class_stats_t* reg = &stats.classes[SPI_STATS_CLASS_REGISTER];
+    wizchip_spi_class_stats_t* buf = &stats.classes[SPI_STATS_CLASS_BUFFER];
+    uint8_t frame[BUFFER_SIZE];
+    //The text reply with every counter at 10 digits is longer than BUFFER_SIZE
+    char text[sizeof("SPI#") + 12 * sizeof("4294967295,")];
+
+    wizchip_spi_get_stats(&stats);
+
+    if (socket_info->binary)
+    {
+        protocol_item_t items[] =
         {
-            message->message_type = MSG_SET_SPEED;
-            message->client = socket_info->socket_id;
-            message->value = 2;
+            { MSG_SPI_STATS, reg->transactions }, { MSG_SPI_STATS, reg->bytes_read },
+            { MSG_SPI_STATS, reg->bytes_written }, { MSG_SPI_STATS, reg->max_transaction_us },
+            { MSG_SPI_STATS, buf->transactions }, { MSG_SPI_STATS, buf->bytes_read },
+            { MSG_SPI_STATS, buf->bytes_written }, { MSG_SPI_STATS, buf->max_transaction_us },
+            { MSG_SPI_STATS, stats.single_calls }, { MSG_SPI_STATS, stats.burst_calls },
+            { MSG_SPI_STATS, stats.locked_us }, { MSG_SPI_STATS, stats.max_locked_us },
+        };
 
-            socket_info->receive_size = 0;
-            return true;
+        //One frame with all values
+        server_queue(socket_info, frame, protocol_encode(frame, sizeof(frame), items, sizeof(items) / sizeof(items[0])));
+        return;
+    }
+
+    int size = snprintf(text, sizeof(text),
+                        "SPI%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu#",
+                        reg->transactions, reg->bytes_read, reg->bytes_written, reg->max_transaction_us,
+                        buf->transactions, buf->bytes_read, buf->bytes_written, buf->max_transaction_us,
+                        stats.single_calls, stats.burst_calls, stats.locked_us, stats.max_locked_us);
+
+    if (size <= 0 || size >= sizeof(text))
+    {
+        printf("[%d]: SPI stats reply does not fit, not sent\n", socket_info->socket_id);
+        return;
+    }
+
+    server_queue(socket_info, (const uint8_t*)text, size);
+}
+
+//Reply LAT<stage>,<commands>,<p50 us>,<p99 us>,<max us># for each LATENCY_STAGE_, or one frame of MSG_LATENCY items in this order per stage
+void server_latency(socket_data_t* socket_info)
+{
+    uint8_t frame[BUFFER_SIZE];
+
+    for (uint8_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+    {
+        const latency_histogram_t* histogram = latency_histogram(stage);
+        uint32_t p50 = latency_percentile(stage, 500);
+        uint32_t p99 = latency_percentile(stage, 990);
+
+        if (socket_info->binary)
+        {
+            protocol_item_t items[] =
+            {
+                { MSG_LATENCY, stage }, { MSG_LATENCY, histogram->count },
+                { MSG_LATENCY, p50 }, { MSG_LATENCY, p99 }, { MSG_LATENCY, histogram->max_us },
+            };
+
+            server_queue(socket_info, frame, protocol_encode(frame, sizeof(frame), items, sizeof(items) / sizeof(items[0])));
+            continue;
         }
-        if (!strcmp((char*)socket_info->receive_buffer, "SET3"))
+
+        int size = snprintf((char*)frame, sizeof(frame), "LAT%d,%lu,%lu,%lu,%lu#",
+                            stage, histogram->count, p50, p99, histogram->max_us);
+
+        if (size > 0 && size < sizeof(frame))
         {
-            message->message_type = MSG_SET_SPEED;
-            message->client = socket_info->socket_id;
-            message->value = 3;
+            server_queue(socket_info, frame, size);
+        }
+    }
+}
 
-            socket_info->receive_size = 0;
-            return true;
+//A reply or heartbeat in the protocol of the connection
+void server_send_item(socket_data_t* socket_info, uint8_t type, int32_t value)
+{
+    uint8_t frame[PROTOCOL_HEADER_SIZE + PROTOCOL_ITEM_SIZE + PROTOCOL_CRC_SIZE];
+    int size = 0;
+
+    if (socket_info->binary)
+    {
+        protocol_item_t item = { type, value };
+
+        size = protocol_encode(frame, sizeof(frame), &item, 1);
+    }
+    else if (type == MSG_CURRENT_SPEEED)
+    {
+        size = snprintf((char*)frame, sizeof(frame), "S%ld#", (long)value);
+    }
+    else if (type == MSG_REMAINING_TIME)
+    {
+        size = snprintf((char*)frame, sizeof(frame), "T%ld#", (long)value);
+    }
+    else if (type == MSG_KEEPALIVE)
+    {
+        size = snprintf((char*)frame, sizeof(frame), "HB#");
+    }
+    else if (type == MSG_MEMORY_PROFILE)
+    {
+        size = snprintf((char*)frame, sizeof(frame), "MEM%ld#", (long)value);
+    }
+    else if (type == MSG_MEMORY_QUEUED)
+    {
+        size = snprintf((char*)frame, sizeof(frame), "MEMQ%ld#", (long)value);
+    }
+
+    if (size > 0 && size < sizeof(frame))
+    {
+        server_queue(socket_info, frame, size);
+    }
+}
+
+//Queue a frame behind the others, they leave together with the next send.
+//A frame that does not fit is dropped: the client stopped reading and gets the next reply or publication.
+void server_queue(socket_data_t* socket_info, const uint8_t* frame, uint16_t len)
+{
+    if (!tx_queue_put(&socket_info->tx_queue, frame, len))
+    {
+        printf("[%d]: TX queue full, frame dropped\n",socket_info->socket_id);
+    }
+}
+
+//Send as much of the queue as Sn_TX_FSR allows with one SEND command, never waits for room
+int32_t server_flush(socket_data_t* socket_info)
+{
+    const uint8_t* parts[2];
+    uint16_t lens[2];
+    int32_t space = wizchip_socket_send_space(socket_info->socket_id, &socket_info->snapshot);
+
+    if (space <= 0)
+    {
+        return space;
+    }
+
+    uint8_t count = tx_queue_peek(&socket_info->tx_queue, space, parts, lens);
+    int32_t ret = wizchip_socket_send_segments(socket_info->socket_id, &socket_info->snapshot, parts, lens, count);
+
+    if (ret > 0)
+    {
+        tx_queue_release(&socket_info->tx_queue, ret);
+        socket_info->tx_queue.sends++;
+
+        //The traced reply was queued before this send, it left with it or with an earlier part of the queue
+        if (socket_info->trace_pending)
+        {
+            socket_info->trace[HOP_SENT] = latency_timestamp(time_us_64());
+            latency_record(socket_info->trace);
+            socket_info->trace_pending = false;
         }
-        if (!strcmp((char*)socket_info->receive_buffer, "HB"))
+    }
+
+    return ret;
+}
+
+//Serialize a publication once for the text and once for the binary subscribers
+void server_publish(message_t* message)
+{
+    message_release(server_publication.message);
+    server_publication.message = message_ref(message);
+
+    protocol_item_t item = { message->message_type, message->value };
+    const char* prefix = (message->message_type == MSG_REMAINING_TIME) ? "T" : "S";
+
+    server_publication.text_size = snprintf((char*)server_publication.text, sizeof(server_publication.text), "%s%ld#", prefix, (long)message->value);
+    server_publication.frame_size = protocol_encode(server_publication.frame, sizeof(server_publication.frame), &item, 1);
+}
+
+void server_accepted(socket_data_t* socket_info)
+{
+    uint8_t listeners = 0;
+
+    for(int i = 0; i < LISTENING_SOCKET_COUNT; ++i)
+    {
+        listeners += socket_data[i].listening ? 1 : 0;
+    }
+
+    //Only a connect proves that clients wait, the W5x00 refuses the ones that find no listener without a trace
+    if (listeners < SERVER_POOL_SPARE)
+    {
+        server_pool.demand = true;
+    }
+
+    server_pool.accepts++;
+}
+
+//Keep SERVER_POOL_SPARE listeners: when a new client took the last one, the client that has been idle longest
+//is closed and its socket listens again. Idle counts from the last command, a heartbeat keeps the connection
+//but not the socket. Clients that sent a command within SERVER_EVICT_IDLE_US are kept, until one of them is
+//idle long enough the W5x00 refuses new clients. A full pool without a new connect evicts nobody.
+void server_admit(uint64_t now, uint64_t* next_poll)
+{
+    socket_data_t* idlest = NULL;
+
+    server_pool.listeners = 0;
+    server_pool.clients = 0;
+
+    for(int i = 0; i < LISTENING_SOCKET_COUNT; ++i)
+    {
+        socket_data_t* socket_info = &socket_data[i];
+
+        server_pool.listeners += socket_info->listening ? 1 : 0;
+
+        if (socket_info->socket_open)
         {
-            message->message_type = MSG_KEEPALIVE;
-            message->client = socket_info->socket_id;
-            message->value = 0;
+            server_pool.clients++;
 
-            socket_info->receive_size = 0;
-            return true;
+            if (!idlest || socket_info->last_request < idlest->last_request)
+            {
+                idlest = socket_info;
+            }
         }
+    }
 
-        //We received a end character, but did not recognise the type; reset the buffer
-        socket_info->receive_size = 0;
+    if (server_pool.clients > server_pool.max_clients)
+    {
+        server_pool.max_clients = server_pool.clients;
     }
 
-    return false;
+#ifndef SERVER_ADMISSION_REJECT
+    if (server_pool.listeners >= SERVER_POOL_SPARE)
+    {
+        server_pool.demand = false;
+    }
+
+    if (server_pool.demand && idlest)
+    {
+        uint64_t evictable = idlest->last_request + SERVER_EVICT_IDLE_US;
+
+        if (now >= evictable)
+        {
+            //The connection closes and listens again in this resume
+            idlest->evict = true;
+            idlest->events = SERVER_WAIT_TIMER;
+            server_connection(idlest);
+            server_resumes++;
+            server_pool.evictions++;
+            server_pool.clients--;
+            server_pool.listeners += idlest->listening ? 1 : 0;
+            server_pool.demand = false;
+        }
+        else if (evictable < *next_poll)
+        {
+            //Look again when the idlest client may be evicted
+            *next_poll = evictable;
+        }
+    }
+#endif
+
+    //Time the pool refused clients
+    if (server_pool.listeners == 0 && server_pool.full_since == 0)
+    {
+        server_pool.full_since = now;
+    }
+    else if (server_pool.listeners > 0 && server_pool.full_since != 0)
+    {
+        server_pool.full_us += now - server_pool.full_since;
+        server_pool.full_since = 0;
+    }
 }
@@ -1,13 +1,45 @@
 #ifndef B05D9526_ED76_4381_A517_160F0993D8C9
 #define B05D9526_ED76_4381_A517_160F0993D8C9
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+#include "wizchip_conf.h"
 
 #define LISTENING_PORT          1234
-#define LISTENING_SOCKET_COUNT  4
-#define BASE_PORT_ID            2
+//Connection pool: every W5x00 socket but the DHCP socket listens on LISTENING_PORT
+#ifndef LISTENING_SOCKET_COUNT
+#define LISTENING_SOCKET_COUNT  (_WIZCHIP_SOCK_NUM_ - 1)
+#endif
 #define KEEP_ALIVE_SECONDS      10
 #define TIMEOUT_SECONDS         30
+#define SERVER_POOL_SPARE       1       // listeners kept for new clients, the longest idle client is evicted for them once a client took the last one
+#define SERVER_EVICT_IDLE_US    (KEEP_ALIVE_SECONDS * 1000 * 1000)  // a client that sent a command other than HB# within a heartbeat interval is never evicted
+//#define SERVER_ADMISSION_REJECT       // if you want new clients refused by the W5x00 instead of evicting an idle one when the pool is full, uncomment.
+#define SERVER_SWEEP_TICKS      1000    // socket memory profile check
+#define SERVER_SEND_RETRY_US    1000    // poll interval while a send waits for SENDOK
+#define SERVER_OPEN_RETRY_US    (1000 * 1000)
+#define SERVER_SOCKET_INTERRUPTS (Sn_IR_CON | Sn_IR_DISCON | Sn_IR_RECV | Sn_IR_TIMEOUT)
 
+//What a connection waits for, the scheduler resumes it when one of them happened
+#define SERVER_WAIT_SOCKET      0x01    // a socket interrupt: connect, disconnect, receive, timeout
+#define SERVER_WAIT_WRITABLE    0x02    // SENDOK, polled as it does not raise an interrupt
+#define SERVER_WAIT_TIMER       0x04    // the deadline of the connection: heartbeat, timeout, retry
+#define SERVER_WAIT_REPLY       0x08    // a reply of the control tasks for this client
+#define SERVER_WAIT_PUBLISH     0x10    // a publication for the subscribers
+
+//#define SERVER_GET_QUEUED             // if you want status requests to go through the queues to ventcontrol_task instead of being answered from its state snapshot, uncomment.
+//#define SERVER_SPI_STATS              // if you want to print the SPI transactions per server loop and the socket memory use, uncomment.
+#define SERVER_SPI_STATS_SECONDS 10
+
+
+//Hands a message block from a tcp client to the control tasks, false when there is no room.
+//The reference of the block goes with it when the message was taken.
+typedef bool (*server_deliver_t)(message_t* message);
 
 void server_task(void* argument);
+void server_start(void (*interrupt_callback)(void));
+uint64_t server_poll(message_t* send_message, bool sweep, server_deliver_t deliver);
+void server_stop(void);
+bool server_sweep_pending(void);
 
 #endif /* B05D9526_ED76_4381_A517_160F0993D8C9 */
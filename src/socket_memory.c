@@ -0,0 +1,177 @@
+#include "socket_memory.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "wizchip_conf.h"
+#include "w5x00_socket.h"
+
+static const socket_memory_profile_t socket_memory_profiles[SOCKET_MEMORY_PROFILE_COUNT] =
+{
+    //name       primary   listener  max KB
+    { "default", { 1, 1 }, { 1, 1 }, 2 },
+    { "fan-in",  { 1, 1 }, { 1, 1 }, 1 },
+    { "bulk",    { 6, 1 }, { 1, 1 }, SOCKET_MEMORY_TOTAL_KB },
+};
+
+static volatile uint8_t selected_profile = SOCKET_MEMORY_PROFILE;
+static uint8_t applied_profile = SOCKET_MEMORY_PROFILE_COUNT;
+static uint8_t applied_listener_mask = 0;
+
+//Largest buffer size, a power of two, that fits in kb
+static uint8_t socket_memory_fit(uint16_t kb)
+{
+    uint8_t size = SOCKET_MEMORY_TOTAL_KB;
+
+    while (size > kb)
+    {
+        size >>= 1;
+    }
+
+    return size;
+}
+
+//Buffer of a listener for a share of the free memory, every listener needs one even when the share is below 1 KB
+static uint8_t socket_memory_slot(const socket_memory_profile_t* profile, uint16_t share)
+{
+    if (share > profile->max_kb)
+    {
+        share = profile->max_kb;
+    }
+
+    return share ? socket_memory_fit(share) : 1;
+}
+
+//Share the memory left after DHCP between the listeners; unused sockets get nothing. Every other listener gets
+//its share by weight, the first listener what is left after their power of two slots.
+static void socket_memory_partition(const socket_memory_profile_t* profile, uint8_t listener_mask, uint8_t* kb[2])
+{
+    for (int direction = 0; direction < 2; direction++)
+    {
+        uint16_t free_kb = SOCKET_MEMORY_TOTAL_KB - SOCKET_MEMORY_DHCP_KB;
+        uint16_t total_weight = 0;
+        uint16_t others_kb = 0;
+        int primary = -1;
+
+        memset(kb[direction], 0, _WIZCHIP_SOCK_NUM_);
+        kb[direction][SOCKET_MEMORY_DHCP_SOCKET] = SOCKET_MEMORY_DHCP_KB;
+
+        for (int sn = 0; sn < _WIZCHIP_SOCK_NUM_; sn++)
+        {
+            if (listener_mask & (1 << sn))
+            {
+                total_weight += (primary < 0) ? profile->primary_weight[direction] : profile->listener_weight[direction];
+                primary = (primary < 0) ? sn : primary;
+            }
+        }
+
+        if (primary < 0)
+        {
+            continue;
+        }
+
+        for (int sn = primary + 1; sn < _WIZCHIP_SOCK_NUM_; sn++)
+        {
+            if (listener_mask & (1 << sn))
+            {
+                kb[direction][sn] = socket_memory_slot(profile, (free_kb * profile->listener_weight[direction]) / total_weight);
+                others_kb += kb[direction][sn];
+            }
+        }
+
+        kb[direction][primary] = socket_memory_slot(profile, (others_kb < free_kb) ? free_kb - others_kb : 0);
+    }
+}
+
+void socket_memory_initialize(void)
+{
+    socket_memory_apply(0);
+}
+
+//Takes effect with the next socket_memory_apply, false for an unknown profile
+bool socket_memory_select(int profile)
+{
+    if (profile < 0 || profile >= SOCKET_MEMORY_PROFILE_COUNT)
+    {
+        return false;
+    }
+
+    selected_profile = profile;
+    return true;
+}
+
+//The pool mask is fixed from server_start to server_stop, only a newly selected profile is pending
+bool socket_memory_pending(void)
+{
+    return selected_profile != applied_profile;
+}
+
+//Fails with SOCKET_MEMORY_BUSY while a socket whose buffer would move has a connection, retry later
+int8_t socket_memory_apply(uint8_t listener_mask)
+{
+    uint8_t profile = selected_profile;
+    uint8_t tx_kb[_WIZCHIP_SOCK_NUM_];
+    uint8_t rx_kb[_WIZCHIP_SOCK_NUM_];
+    uint8_t* kb[2] = { tx_kb, rx_kb };
+    int8_t ret;
+
+    socket_memory_partition(&socket_memory_profiles[profile], listener_mask, kb);
+
+    if ((ret = wizchip_socket_set_memory(tx_kb, rx_kb)) != SOCKET_MEMORY_OK)
+    {
+        return ret;
+    }
+
+    applied_profile = profile;
+    applied_listener_mask = listener_mask;
+
+    printf("Socket memory profile %s, TX/RX KB:", socket_memory_profiles[profile].name);
+    for (int sn = 0; sn < _WIZCHIP_SOCK_NUM_; sn++)
+    {
+        printf(" %d/%d", tx_kb[sn], rx_kb[sn]);
+    }
+    printf("\n");
+
+    return SOCKET_MEMORY_OK;
+}
+
+void socket_memory_print_stats(void)
+{
+    wizchip_socket_memory_stats_t stats;
+    const char* name = (applied_profile < SOCKET_MEMORY_PROFILE_COUNT) ? socket_memory_profiles[applied_profile].name : "none";
+    uint16_t used_kb[2] = { 0, 0 };
+    uint16_t others_kb[2] = { 0, 0 };
+    uint8_t primary_kb[2] = { 0, 0 };
+    uint8_t others = 0;
+    bool primary = true;
+
+    printf("Socket memory profile %s, TX/RX KB (peak bytes):", name);
+    for (int sn = 0; sn < _WIZCHIP_SOCK_NUM_; sn++)
+    {
+        wizchip_socket_get_memory_stats(sn, &stats);
+        printf(" %d/%d (%d/%d)", stats.tx_kb, stats.rx_kb, stats.tx_peak, stats.rx_peak);
+
+        used_kb[0] += stats.tx_kb;
+        used_kb[1] += stats.rx_kb;
+
+        if (applied_listener_mask & (1 << sn))
+        {
+            if (primary)
+            {
+                primary_kb[0] = stats.tx_kb;
+                primary_kb[1] = stats.rx_kb;
+                primary = false;
+            }
+            else
+            {
+                others_kb[0] += stats.tx_kb;
+                others_kb[1] += stats.rx_kb;
+                others++;
+            }
+        }
+    }
+    printf("\n");
+
+    printf("Socket memory split, TX/RX KB: first listener %d/%d, %d other listeners %d/%d, DHCP %d/%d, unused %d/%d\n",
+           primary_kb[0], primary_kb[1], others, others_kb[0], others_kb[1], SOCKET_MEMORY_DHCP_KB, SOCKET_MEMORY_DHCP_KB,
+           SOCKET_MEMORY_TOTAL_KB - used_kb[0], SOCKET_MEMORY_TOTAL_KB - used_kb[1]);
+}
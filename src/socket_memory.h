@@ -0,0 +1,29 @@
+#ifndef A3C6F2D1_5E8B_4A7C_9D14_7B2E0F6C8A35
+#define A3C6F2D1_5E8B_4A7C_9D14_7B2E0F6C8A35
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SOCKET_MEMORY_PROFILE_DEFAULT   0   // 2 KB for every listener, like the ioLibrary default
+#define SOCKET_MEMORY_PROFILE_FAN_IN    1   // 1 KB for every listener, many small control connections
+#define SOCKET_MEMORY_PROFILE_BULK      2   // most of the TX memory for one telemetry stream on the first listener
+#define SOCKET_MEMORY_PROFILE_COUNT     3
+
+#define SOCKET_MEMORY_PROFILE           SOCKET_MEMORY_PROFILE_DEFAULT   // profile at startup
+#define SOCKET_MEMORY_DHCP_SOCKET       0
+#define SOCKET_MEMORY_DHCP_KB           1   // DHCP messages are below 600 bytes
+
+typedef struct socket_memory_profile_t
+{
+    const char* name;
+    uint8_t primary_weight[2];      //TX, RX weight of the first listener, it gets the memory the others leave
+    uint8_t listener_weight[2];     //TX, RX share of the free memory for every other listener
+    uint8_t max_kb;                 //Largest buffer of a listener
+} socket_memory_profile_t;
+
+void socket_memory_initialize(void);
+bool socket_memory_select(int profile);
+bool socket_memory_pending(void);
+int8_t socket_memory_apply(uint8_t listener_mask);
+void socket_memory_print_stats(void);
+
+#endif /* A3C6F2D1_5E8B_4A7C_9D14_7B2E0F6C8A35 */
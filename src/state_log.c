@@ -0,0 +1,230 @@
+#include "state_log.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "protocol.h"
+
+_Static_assert(sizeof(state_log_record_t) == STATE_LOG_RECORD_SIZE, "A record fills its slot");
+_Static_assert(FLASH_REGION_SECTORS >= 2, "The sector with the latest record is never the one erased");
+
+static bool state_log_ready = false;            //The region is usable and was scanned
+static uint32_t state_log_head = 0;             //Slot of the next record
+static uint32_t state_log_sequence = 0;         //Of the latest record
+static bool state_log_pending = false;          //The state differs from the latest record
+static uint64_t state_log_written_at = 0;
+
+//The latest state handed to state_log_update, written or pending
+static int state_log_speed = PROGRAM_NO_SPEED;
+static program_state_t state_log_program;
+
+static state_log_stats_t state_log_stats;
+
+//The magic is not covered, it is programmed after the rest of the record
+static uint16_t state_log_crc(const state_log_record_t* record)
+{
+    return protocol_crc16((const uint8_t*)record + 4, STATE_LOG_RECORD_SIZE - 4);
+}
+
+static bool state_log_blank(const state_log_record_t* record)
+{
+    const uint8_t* data = (const uint8_t*)record;
+
+    for (uint8_t i = 0; i < STATE_LOG_RECORD_SIZE; i++)
+    {
+        if (data[i] != 0xff)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//Finds the record with the highest sequence and a good CRC, false on a blank region or without the region
+bool state_log_restore(int* speed, program_state_t* program, uint64_t now)
+{
+    state_log_record_t record;
+    state_log_record_t latest;
+    uint32_t latest_slot = 0;
+    bool found = false;
+
+    state_log_ready = flash_region_initialize();
+    state_log_pending = false;
+    state_log_written_at = now;
+    state_log_head = 0;
+    state_log_sequence = 0;
+    state_log_stats.restore_slots = 0;
+    state_log_stats.restore_invalid = 0;
+
+    if (!state_log_ready)
+    {
+        return false;
+    }
+
+    for (uint32_t slot = 0; slot < STATE_LOG_SLOTS; slot++)
+    {
+        flash_region_read(slot * STATE_LOG_RECORD_SIZE, &record, sizeof(record));
+        state_log_stats.restore_slots++;
+
+        if (record.magic != STATE_LOG_MAGIC || record.crc != state_log_crc(&record))
+        {
+            state_log_stats.restore_invalid += state_log_blank(&record) ? 0 : 1;
+            continue;
+        }
+
+        //Compared as a difference, the sequence may wrap
+        if (!found || (int32_t)(record.sequence - latest.sequence) > 0)
+        {
+            latest = record;
+            latest_slot = slot;
+            found = true;
+        }
+    }
+
+    if (found)
+    {
+        state_log_head = (latest_slot + 1) % STATE_LOG_SLOTS;
+        state_log_sequence = latest.sequence;
+
+        memset(program, 0, sizeof(program_state_t));
+        *speed = latest.speed;
+        program->ends_at = latest.program_seconds ? now + (uint64_t)latest.program_seconds * 1000 * 1000 : UINT64_MAX;
+        program->revert_speed = latest.program_seconds ? latest.revert_speed : PROGRAM_NO_SPEED;
+        program->push_seconds = latest.push_seconds;
+        program->schedule_count = (latest.schedule_count <= PROGRAM_SCHEDULE_SIZE) ? latest.schedule_count : 0;
+        memcpy(program->schedule_hhmm, latest.schedule_hhmm, sizeof(program->schedule_hhmm));
+        memcpy(program->schedule_speed, latest.schedule_speed, sizeof(program->schedule_speed));
+
+        //What was restored is not written again
+        state_log_speed = *speed;
+        state_log_program = *program;
+    }
+    else
+    {
+        //Nothing to compare with, the first state handed to state_log_update is written
+        state_log_speed = PROGRAM_NO_SPEED;
+        memset(&state_log_program, 0, sizeof(state_log_program));
+    }
+
+    state_log_stats.restore_us = time_us_64() - now;
+
+    return found;
+}
+
+//Two programs per record, the body and then the magic, each as a page with 0xff around the record
+static void state_log_program_slot(uint32_t slot, const state_log_record_t* record)
+{
+    uint8_t page[FLASH_REGION_PAGE_SIZE];
+    uint32_t offset = slot * STATE_LOG_RECORD_SIZE;
+    uint32_t page_offset = offset % FLASH_REGION_PAGE_SIZE;
+    uint16_t magic = STATE_LOG_MAGIC;
+
+    memset(page, 0xff, sizeof(page));
+    memcpy(page + page_offset, record, STATE_LOG_RECORD_SIZE);
+    flash_region_program(offset - page_offset, page);
+
+    memset(page, 0xff, sizeof(page));
+    memcpy(page + page_offset, &magic, sizeof(magic));
+    flash_region_program(offset - page_offset, page);
+}
+
+static void state_log_write(uint64_t now)
+{
+    state_log_record_t record;
+    state_log_record_t slot_data;
+    uint32_t program_seconds = 0;
+
+    if (state_log_program.ends_at != UINT64_MAX && state_log_program.ends_at > now)
+    {
+        program_seconds = (state_log_program.ends_at - now + (1000 * 1000) - 1) / (1000 * 1000);
+    }
+
+    memset(&record, 0xff, sizeof(record));
+    record.sequence = state_log_sequence + 1;
+    record.speed = state_log_speed;
+    record.revert_speed = program_seconds ? state_log_program.revert_speed : PROGRAM_NO_SPEED;
+    record.schedule_count = state_log_program.schedule_count;
+    record.program_seconds = program_seconds;
+    record.push_seconds = state_log_program.push_seconds;
+    memcpy(record.schedule_hhmm, state_log_program.schedule_hhmm, sizeof(record.schedule_hhmm));
+    memcpy(record.schedule_speed, state_log_program.schedule_speed, sizeof(record.schedule_speed));
+    record.crc = state_log_crc(&record);
+
+    for (uint32_t tries = 0; tries < STATE_LOG_SLOTS; tries++)
+    {
+        uint32_t slot = state_log_head;
+
+        state_log_head = (state_log_head + 1) % STATE_LOG_SLOTS;
+
+        //The first slot of a sector erases it, the records in it are older than any in the other sectors
+        if ((slot % STATE_LOG_SECTOR_SLOTS) == 0)
+        {
+            flash_region_erase(slot / STATE_LOG_SECTOR_SLOTS);
+            state_log_stats.erases++;
+        }
+        else
+        {
+            flash_region_read(slot * STATE_LOG_RECORD_SIZE, &slot_data, sizeof(slot_data));
+
+            if (!state_log_blank(&slot_data))
+            {
+                state_log_stats.skipped++;
+                continue;
+            }
+        }
+
+        state_log_program_slot(slot, &record);
+        state_log_sequence = record.sequence;
+        state_log_stats.records++;
+        return;
+    }
+}
+
+//Called with the state after every change, writes it once STATE_LOG_INTERVAL_US passed since the last
+//record. Returns when a merged change is due, UINT64_MAX when the log holds the state.
+uint64_t state_log_update(int speed, const program_state_t* program, uint64_t now)
+{
+    if (!state_log_ready)
+    {
+        return UINT64_MAX;
+    }
+
+    if (speed != state_log_speed || memcmp(program, &state_log_program, sizeof(program_state_t)) != 0)
+    {
+        state_log_stats.merged += state_log_pending ? 1 : 0;
+        state_log_pending = true;
+        state_log_speed = speed;
+        state_log_program = *program;
+    }
+
+    if (!state_log_pending)
+    {
+        return UINT64_MAX;
+    }
+
+    //Counted from the restore as well, the changes right after a reboot go into one record
+    if (now < state_log_written_at + STATE_LOG_INTERVAL_US)
+    {
+        return state_log_written_at + STATE_LOG_INTERVAL_US;
+    }
+
+    state_log_write(now);
+    state_log_pending = false;
+    state_log_written_at = now;
+
+    return UINT64_MAX;
+}
+
+void state_log_get_stats(state_log_stats_t* stats)
+{
+    *stats = state_log_stats;
+}
+
+void state_log_print_stats(void)
+{
+    printf("State log: %ld records, %ld sector erases, %ld changes merged, %ld slots skipped, "
+           "restore read %ld slots (%ld invalid) in %ld us\n", state_log_stats.records, state_log_stats.erases,
+           state_log_stats.merged, state_log_stats.skipped, state_log_stats.restore_slots,
+           state_log_stats.restore_invalid, state_log_stats.restore_us);
+}
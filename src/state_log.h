@@ -0,0 +1,52 @@
+#ifndef C1E7A4D9_8B26_4F3C_95A1_D4B60E2F7C83
+#define C1E7A4D9_8B26_4F3C_95A1_D4B60E2F7C83
+#include <stdbool.h>
+#include <stdint.h>
+#include "program.h"
+#include "flash_region.h"
+
+//The speed, a program in progress and the schedule, kept across reboots in the flash region.
+//Append only: every record holds the whole state and goes to the next slot, a sector is erased when the
+//log comes back to it. The writes go round all sectors of the region, so they wear evenly.
+//A record is written without its magic first and the magic is programmed last: a power cut leaves a
+//record without magic, or one whose CRC does not match, and the restore takes the record before it.
+//The restore reads every slot once, its time is bounded by the size of the region.
+#define STATE_LOG_RECORD_SIZE       64
+#define STATE_LOG_SLOTS             (FLASH_REGION_SIZE / STATE_LOG_RECORD_SIZE)
+#define STATE_LOG_SECTOR_SLOTS      (FLASH_REGION_SECTOR_SIZE / STATE_LOG_RECORD_SIZE)
+#define STATE_LOG_MAGIC             0x5653  // 'VS'
+#define STATE_LOG_INTERVAL_US       (5 * 1000 * 1000)   // shortest time between two records, changes in between are merged
+
+typedef struct state_log_record_t
+{
+    uint16_t magic;
+    uint16_t crc;                       //protocol_crc16 of everything behind it
+    uint32_t sequence;                  //The record with the highest sequence is the state
+    int8_t speed;
+    int8_t revert_speed;                //PROGRAM_NO_SPEED without a program
+    uint8_t schedule_count;
+    uint8_t reserved;
+    uint32_t program_seconds;           //Time the program had left when it was written
+    uint32_t push_seconds;
+    uint16_t schedule_hhmm[PROGRAM_SCHEDULE_SIZE];
+    int8_t schedule_speed[PROGRAM_SCHEDULE_SIZE];
+    uint8_t padding[20];                //0xff, free for later fields
+} state_log_record_t;
+
+typedef struct state_log_stats_t
+{
+    uint32_t records;
+    uint32_t erases;
+    uint32_t merged;                    //Changes that went into a later record
+    uint32_t skipped;                   //Slots left written by a power cut, not used again before an erase
+    uint32_t restore_slots;             //Slots read by the restore
+    uint32_t restore_invalid;           //Records without magic or with a bad CRC
+    uint32_t restore_us;
+} state_log_stats_t;
+
+bool state_log_restore(int* speed, program_state_t* program, uint64_t now);
+uint64_t state_log_update(int speed, const program_state_t* program, uint64_t now);
+void state_log_get_stats(state_log_stats_t* stats);
+void state_log_print_stats(void);
+
+#endif /* C1E7A4D9_8B26_4F3C_95A1_D4B60E2F7C83 */
@@ -0,0 +1,58 @@
+#ifndef A9C4E2B7_6F13_4D8A_9E52_7B1D3F0C6A84
+#define A9C4E2B7_6F13_4D8A_9E52_7B1D3F0C6A84
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/sync.h"
+
+//The state of ventcontrol_task for readers on any task or core, without a lock and without the queues.
+//Seqlock: one writer makes the sequence odd while it changes the state and even again when it is done.
+//A reader copies the state and tries again when the sequence was odd or moved during the copy.
+typedef struct vent_state_t
+{
+    int speed;
+    uint64_t program_ends_at;       //time_us_64 the running program reverts, UINT64_MAX without one
+} vent_state_t;
+
+typedef struct state_snapshot_t
+{
+    volatile uint32_t sequence;
+    volatile vent_state_t state;
+} state_snapshot_t;
+
+static inline void state_snapshot_write(state_snapshot_t* snapshot, const vent_state_t* state)
+{
+    uint32_t sequence = snapshot->sequence;
+
+    snapshot->sequence = sequence + 1;
+
+    //Readers see the odd sequence before any part of the new state
+    __dmb();
+    snapshot->state = *state;
+
+    //The new state is complete before the sequence is even again
+    __dmb();
+    snapshot->sequence = sequence + 2;
+}
+
+//Returns the number of retries, a reader only waits while the writer is in the middle of a write
+static inline uint32_t state_snapshot_read(const state_snapshot_t* snapshot, vent_state_t* state)
+{
+    uint32_t retries = 0;
+
+    while (true)
+    {
+        uint32_t sequence = snapshot->sequence;
+
+        __dmb();
+        *state = snapshot->state;
+        __dmb();
+
+        if (!(sequence & 1) && sequence == snapshot->sequence)
+        {
+            return retries;
+        }
+        retries++;
+    }
+}
+
+#endif /* A9C4E2B7_6F13_4D8A_9E52_7B1D3F0C6A84 */
@@ -0,0 +1,87 @@
+#ifndef A9E2C7F4_1D5B_4836_B0A3_6C8F2E47D915
+#define A9E2C7F4_1D5B_4836_B0A3_6C8F2E47D915
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TX_QUEUE_SIZE       256     // power of two, bytes per connection
+
+//Byte ring of the frames waiting for room in the W5x00 TX buffer.
+//A frame is queued whole or not at all; the TCP stream may leave in any split.
+typedef struct tx_queue_t
+{
+    uint16_t head;
+    uint16_t tail;
+    uint8_t data[TX_QUEUE_SIZE];
+    uint32_t frames;            //Frames queued
+    uint32_t sends;             //SEND commands that carried them
+    uint32_t dropped;           //Frames that did not fit
+    uint16_t max_depth;         //Most bytes queued
+} tx_queue_t;
+
+static inline void tx_queue_reset(tx_queue_t* queue)
+{
+    queue->head = 0;
+    queue->tail = 0;
+}
+
+static inline uint16_t tx_queue_depth(const tx_queue_t* queue)
+{
+    return (uint16_t)(queue->head - queue->tail);
+}
+
+static inline bool tx_queue_empty(const tx_queue_t* queue)
+{
+    return queue->head == queue->tail;
+}
+
+static inline bool tx_queue_put(tx_queue_t* queue, const uint8_t* frame, uint16_t len)
+{
+    uint16_t depth = tx_queue_depth(queue);
+
+    if (len == 0 || len > TX_QUEUE_SIZE - depth)
+    {
+        queue->dropped += (len > 0) ? 1 : 0;
+        return false;
+    }
+
+    uint16_t offset = queue->head % TX_QUEUE_SIZE;
+    uint16_t first = (len < TX_QUEUE_SIZE - offset) ? len : TX_QUEUE_SIZE - offset;
+
+    memcpy(queue->data + offset, frame, first);
+    memcpy(queue->data, frame + first, len - first);
+    queue->head += len;
+    queue->frames++;
+
+    if (depth + len > queue->max_depth)
+    {
+        queue->max_depth = depth + len;
+    }
+
+    return true;
+}
+
+//The oldest len bytes as up to two contiguous parts, returns the number of parts
+static inline uint8_t tx_queue_peek(const tx_queue_t* queue, uint16_t len, const uint8_t** parts, uint16_t* lens)
+{
+    uint16_t offset = queue->tail % TX_QUEUE_SIZE;
+
+    if (len > tx_queue_depth(queue))
+    {
+        len = tx_queue_depth(queue);
+    }
+
+    parts[0] = queue->data + offset;
+    lens[0] = (len < TX_QUEUE_SIZE - offset) ? len : TX_QUEUE_SIZE - offset;
+    parts[1] = queue->data;
+    lens[1] = len - lens[0];
+
+    return (lens[1] > 0) ? 2 : 1;
+}
+
+static inline void tx_queue_release(tx_queue_t* queue, uint16_t len)
+{
+    queue->tail += len;
+}
+
+#endif /* A9E2C7F4_1D5B_4836_B0A3_6C8F2E47D915 */
@@ -1,9 +1,11 @@
 #ifndef B0B500A7_6A18_4F4B_9AF0_44F78775ED2E
 #define B0B500A7_6A18_4F4B_9AF0_44F78775ED2E
 #include <stdbool.h>
+#include <stdint.h>
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "semphr.h"
+#include "task.h"
 
 #define MAX_CONN             5
 #define MAX_QUEUE_LENGTH     10
@@ -15,6 +17,27 @@
 #define MSG_SET_SPEED        3
 #define MSG_REMAINING_TIME   4
 #define MSG_KEEPALIVE        5
+#define MSG_SPI_STATS        6
+#define MSG_BINARY           7
+#define MSG_SUBSCRIBE        8
+#define MSG_LATENCY          9
+#define MSG_PROGRAM          10     // value speed << 16 | minutes, 0 cancels the running program
+#define MSG_SCHEDULE         11     // value hhmm << 16 | speed every day, -1 clears the schedule
+#define MSG_CLOCK            12     // value hhmmss, the time of day
+#define MSG_PUSH_INTERVAL    13     // value seconds between remaining time publications of a program
+#define MSG_MEMORY_PROFILE   14     // value SOCKET_MEMORY_PROFILE_, the reply when the server applied it, -1 for an unknown one
+#define MSG_MEMORY_QUEUED    15     // value SOCKET_MEMORY_PROFILE_, the reply when a client holds a socket whose buffer moves
+
+#define MESSAGE_CLIENT_ALL   -1     // client of a publication, pushed to every subscribed client
+
+//Hops of a command on its way to the control tasks and back, the low 32 bits of time_us_64 when it passed them
+#define HOP_RECEIVED         0      // read from the W5x00 RX buffer
+#define HOP_DELIVERED        1      // handed to receive_queue
+#define HOP_DEQUEUED         2      // taken from receive_queue by ventcontrol_task
+#define HOP_REPLIED          3      // reply handed to send_queue
+#define HOP_REPLY_TAKEN      4      // reply taken from send_queue by the server
+#define HOP_SENT             5      // reply left with a SEND command
+#define HOP_COUNT            6
 
 typedef struct server_data_t
 {
@@ -23,12 +46,14 @@ typedef struct server_data_t
   QueueHandle_t receive_queue;
   QueueHandle_t send_queue;
   QueueHandle_t blink_queue;
+  TaskHandle_t server_task;
 } server_data_t;
 
 typedef struct message_t {
   int client;
   int value;
   int message_type;
+  uint32_t hops[HOP_COUNT];   //HOP_ timestamps, 0 for a message that is not traced
 } message_t;
 
 #endif /* B0B500A7_6A18_4F4B_9AF0_44F78775ED2E */
@@ -1,9 +1,15 @@
 #include "ventcontrol.h"
 
 #include "types.h"
+#include "server.h"
+#include "latency.h"
+#include "message_pool.h"
+#include "program.h"
+#include "state_log.h"
 //#include "pico/cyw43_arch.h"
 #include "pico/stdlib.h"
 #include <stdio.h>
+#include <string.h>
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
@@ -11,46 +17,354 @@
 
 #define REL_1 28
 
+static server_data_t* ventcontrol_server_data = NULL;
+static int current_speed = 1;
+static bool relay_on = true;                //Follows current_speed, on for speed 1
+static uint64_t relay_changed_at = 0;
+static ventcontrol_stats_t ventcontrol_stats;
+
+//current_speed and the running program for the server, it answers status requests without the queues
+static state_snapshot_t ventcontrol_snapshot = { 0, { 1, UINT64_MAX } };
+
+//Messages queued on send_queue since the server was notified last
+static uint32_t ventcontrol_queued = 0;
+
+static void ventcontrol_send(message_t* message)
+{
+    if (xQueueSend(ventcontrol_server_data->send_queue, (void *)&message, 10) != pdTRUE)
+    {
+        message_release(message);
+        return;
+    }
+
+    ventcontrol_queued++;
+}
+
 void ventcontrol_task(void *params)
 {
     server_data_t* server_data = (server_data_t*) params;
     printf("Ventcontrol task started.\n");
 
-    int current_speed = 1;
+    ventcontrol_server_data = server_data;
     // gpio_init(REL_1);
     // gpio_set_dir(REL_1, GPIO_OUT);
 
+    uint64_t next_wake = UINT64_MAX;
+#ifdef SERVER_SPI_STATS
+    uint64_t stats_start = time_us_64();
+#endif
+
+    next_wake = ventcontrol_initialize(time_us_64());
+
     while (true) {
-        message_t message;
-        if (xQueueReceive(server_data->receive_queue, (void *)&message, (TickType_t) 1000) == pdTRUE)
+        message_t* batch[VENTCONTROL_BATCH_SIZE];
+        uint8_t count = 0;
+        TickType_t wait_ticks = portMAX_DELAY;
+        uint64_t now = time_us_64();
+
+#ifdef SERVER_SPI_STATS
+        if (next_wake > stats_start + (SERVER_SPI_STATS_SECONDS * 1000 * 1000))
         {
-            printf("Processing message received from client: %d, type: %d\n", message.client, message.message_type);
+            next_wake = stats_start + (SERVER_SPI_STATS_SECONDS * 1000 * 1000);
+        }
+#endif
+
+        //Only a relay change that waits for its dwell time, or the next transition or push of a program,
+        //wakes up the task without a command, right when it is due
+        if (next_wake != UINT64_MAX)
+        {
+            uint64_t wait_us = (next_wake > now) ? (next_wake - now) : 0;
+            uint64_t ticks = (wait_us + (portTICK_PERIOD_MS * 1000) - 1) / (portTICK_PERIOD_MS * 1000);
+
+            //Programs of days are longer than the tick count, the task wakes up early and waits again
+            wait_ticks = (ticks < portMAX_DELAY) ? (TickType_t)ticks : (portMAX_DELAY - 1);
+        }
 
-            if (message.message_type == MSG_SET_SPEED)
+        //Everything that queued up while the task worked or slept is one batch
+        if (xQueueReceive(server_data->receive_queue, (void *)&batch[0], wait_ticks) == pdTRUE)
+        {
+            count = 1;
+            while (count < VENTCONTROL_BATCH_SIZE &&
+                   xQueueReceive(server_data->receive_queue, (void *)&batch[count], 0) == pdTRUE)
             {
-                current_speed = message.value;
-
-                if (current_speed == 1)
-                {
-//                    gpio_put(REL_1, 1);
-                }
-                else
-                {
-//                    gpio_put(REL_1, 0);
-                }
-
-                // //Blink the led in a different task
-                // int blink_time = 200;
-                // xQueueSend(queues.blink_queue, (void *)&blink_time, 10);
+                count++;
             }
+        }
+
+        next_wake = ventcontrol_batch(batch, count, time_us_64(), ventcontrol_send);
+
+        //A wakeup without commands queues program transitions and pushes, the server may sleep without a deadline
+        if (ventcontrol_queued > 0 && server_data->server_task != NULL)
+        {
+            xTaskNotifyGive(server_data->server_task);
+        }
+        ventcontrol_queued = 0;
+
+#ifdef SERVER_SPI_STATS
+        if ((time_us_64() - stats_start) > (SERVER_SPI_STATS_SECONDS * 1000 * 1000))
+        {
+            ventcontrol_print_stats();
+            state_log_print_stats();
+            stats_start = time_us_64();
+        }
+#endif
+    }
+}
+
+//Only the writer changes the snapshot, it reads its own copy without the sequence. A reader task that
+//preempted the write would spin until the time slice ends, no task switch happens during the write.
+static void ventcontrol_publish_state(void)
+{
+    vent_state_t state = { current_speed, program_ends() };
+
+    if (state.speed != ventcontrol_snapshot.state.speed || state.program_ends_at != ventcontrol_snapshot.state.program_ends_at)
+    {
+        vTaskSuspendAll();
+        state_snapshot_write(&ventcontrol_snapshot, &state);
+        xTaskResumeAll();
+    }
+}
+
+//The earliest of a relay change, a program transition or push and a merged change for the state log
+static uint64_t ventcontrol_deadline(uint64_t now)
+{
+    program_state_t program;
+
+    program_get_state(&program);
+
+    uint64_t next_relay = ventcontrol_relay(now);
+    uint64_t next_program = program_deadline();
+    uint64_t next_log = state_log_update(current_speed, &program, now);
+    uint64_t deadline = (next_relay < next_program) ? next_relay : next_program;
+
+    return (next_log < deadline) ? next_log : deadline;
+}
+
+//The speed, program and schedule from before the reboot, the defaults on a blank state log.
+//Returns when ventcontrol_task has to look at the relay or the programs first.
+uint64_t ventcontrol_initialize(uint64_t now)
+{
+    program_state_t program;
+    int speed;
+
+    program_initialize();
+
+    if (state_log_restore(&speed, &program, now) && speed >= 0 && speed <= PROGRAM_MAX_SPEED)
+    {
+        current_speed = speed;
+        program_restore(&program, now);
+        printf("Restored speed %d, %ld s of a program left, %d schedule entries\n",
+               current_speed, program_remaining_seconds(now), program.schedule_count);
+    }
+
+    ventcontrol_publish_state();
+
+    return ventcontrol_deadline(now);
+}
+
+//The speed a command of the batch asks for, target when it does not change the speed
+static int ventcontrol_command(message_t* message, int target, uint64_t now)
+{
+    int speed = target;
+
+    if (message->message_type == MSG_SET_SPEED)
+    {
+        //A speed set by hand ends the running program
+        program_cancel();
+        speed = message->value;
+
+        // //Blink the led in a different task
+        // int blink_time = 200;
+        // xQueueSend(queues.blink_queue, (void *)&blink_time, 10);
+    }
+    else if (message->message_type == MSG_PROGRAM)
+    {
+        int program_speed = (message->value >> 16) & 0xffff;
+        uint32_t minutes = message->value & 0xffff;
+
+        if (message->value != 0 && (minutes == 0 || program_speed > PROGRAM_MAX_SPEED))
+        {
+            printf("Program %08x rejected\n", message->value);
+            return speed;
+        }
+
+        //A new program replaces the running one and reverts to the speed from before both, PRGOFF only ends it
+        int revert_speed = program_cancel();
+        speed = (revert_speed != PROGRAM_NO_SPEED) ? revert_speed : target;
+
+        if (message->value != 0)
+        {
+            program_start(minutes, speed, now);
+            speed = program_speed;
+        }
+    }
+    else if (message->message_type == MSG_SCHEDULE)
+    {
+        if (message->value == -1)
+        {
+            program_schedule_clear();
+        }
+        else if (!program_schedule((message->value >> 16) & 0xffff, message->value & 0xffff, now))
+        {
+            printf("Schedule entry %08x rejected\n", message->value);
+        }
+    }
+    else if (message->message_type == MSG_CLOCK)
+    {
+        if (!program_set_clock(message->value, now))
+        {
+            printf("Clock %06d rejected\n", message->value);
+        }
+    }
+    else if (message->message_type == MSG_PUSH_INTERVAL)
+    {
+        program_set_push_interval(message->value, now);
+    }
+
+    return speed;
+}
+
+static void ventcontrol_publish(int message_type, int value, ventcontrol_send_t send)
+{
+    message_t* publication = message_alloc();
+
+    if (publication != NULL)
+    {
+        publication->client = MESSAGE_CLIENT_ALL;
+        publication->message_type = message_type;
+        publication->value = value;
+        send(publication);
+    }
+}
+
+//Last writer wins: the commands of the batch are applied in order and the speed they end at is applied
+//once. Every command of the batch is answered with it, or with the remaining time of the program, the
+//block of a command becomes its reply. Transitions of programs and the schedule that are due run here too.
+//Returns when the relay or the programs have to be looked at again.
+uint64_t ventcontrol_batch(message_t** batch, uint8_t count, uint64_t now, ventcontrol_send_t send)
+{
+    int target = current_speed;
+    bool requested_on = (current_speed == 1);
+    bool speed_set = false;
+    bool push;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        message_t* message = batch[i];
+
+        latency_stamp(message, HOP_DEQUEUED);
+        printf("Processing message received from client: %d, type: %d\n", message->client, message->message_type);
+
+        int speed = ventcontrol_command(message, target, now);
+
+        if (message->message_type == MSG_SET_SPEED || speed != target)
+        {
+            ventcontrol_stats.coalesced += speed_set ? 1 : 0;
+            speed_set = true;
+            target = speed;
+        }
+
+        //The switching the commands would have caused one by one
+        if ((target == 1) != requested_on)
+        {
+            requested_on = !requested_on;
+            ventcontrol_stats.requested_changes++;
+        }
+    }
+
+    ventcontrol_stats.commands += count;
+    ventcontrol_stats.batches += count ? 1 : 0;
+
+    int due_speed = program_due(now, &push);
+    if (due_speed != PROGRAM_NO_SPEED)
+    {
+        target = due_speed;
+        ventcontrol_stats.requested_changes += ((target == 1) != requested_on) ? 1 : 0;
+    }
 
-            message_t reply_message;
-            reply_message.client = message.client;
-            reply_message.message_type = MSG_CURRENT_SPEEED;
-            reply_message.value = current_speed;
+    bool changed = (current_speed != target);
+    current_speed = target;
 
-            xQueueSend(server_data->send_queue, (void *)&reply_message, 10);
+    //Published before the replies, so a status request answered after a reply sees its speed
+    ventcontrol_publish_state();
 
+    for (uint8_t i = 0; i < count; i++)
+    {
+        message_t* reply_message = batch[i];
+
+        if (reply_message->message_type == MSG_REMAINING_TIME)
+        {
+            reply_message->value = program_remaining_seconds(now);
+        }
+        else
+        {
+            reply_message->message_type = MSG_CURRENT_SPEEED;
+            reply_message->value = current_speed;
         }
+        latency_stamp(reply_message, HOP_REPLIED);
+        send(reply_message);
+    }
+
+    //Pushed once to every subscribed client, so they do not have to poll
+    if (changed)
+    {
+        ventcontrol_publish(MSG_CURRENT_SPEEED, current_speed, send);
+    }
+
+    if (push)
+    {
+        ventcontrol_publish(MSG_REMAINING_TIME, program_remaining_seconds(now), send);
+    }
+
+    return ventcontrol_deadline(now);
+}
+
+//Moves the relay to the current speed once VENTCONTROL_RELAY_DWELL_US passed since its last change,
+//returns the time the pending change is due or UINT64_MAX when the relay is where it should be
+uint64_t ventcontrol_relay(uint64_t now)
+{
+    bool on = (current_speed == 1);
+
+    if (on == relay_on)
+    {
+        return UINT64_MAX;
+    }
+
+    if (ventcontrol_stats.relay_changes > 0 && (now - relay_changed_at) < VENTCONTROL_RELAY_DWELL_US)
+    {
+        return relay_changed_at + VENTCONTROL_RELAY_DWELL_US;
+    }
+
+    if (on)
+    {
+//        gpio_put(REL_1, 1);
+    }
+    else
+    {
+//        gpio_put(REL_1, 0);
     }
+
+    relay_on = on;
+    relay_changed_at = now;
+    ventcontrol_stats.relay_changes++;
+
+    return UINT64_MAX;
+}
+
+//Any task or core, returns the number of times the read was tried again
+uint32_t ventcontrol_read_state(vent_state_t* state)
+{
+    return state_snapshot_read(&ventcontrol_snapshot, state);
+}
+
+void ventcontrol_get_stats(ventcontrol_stats_t* stats)
+{
+    *stats = ventcontrol_stats;
+}
+
+void ventcontrol_print_stats(void)
+{
+    printf("Ventcontrol: %ld commands in %ld batches, %ld speed changes coalesced, relay switched %ld times, "
+           "%ld switches avoided\n", ventcontrol_stats.commands, ventcontrol_stats.batches, ventcontrol_stats.coalesced,
+           ventcontrol_stats.relay_changes, ventcontrol_stats.requested_changes - ventcontrol_stats.relay_changes);
 }
@@ -1,6 +1,31 @@
 #ifndef C8EF045B_AAF1_4CEF_ACE5_68E90696899F
 #define C8EF045B_AAF1_4CEF_ACE5_68E90696899F
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+#include "state_snapshot.h"
+
+#define VENTCONTROL_BATCH_SIZE      MAX_QUEUE_LENGTH    // commands taken from the receive_queue per wake up
+#define VENTCONTROL_RELAY_DWELL_US  0       // shortest time between two relay changes, e.g. (500 * 1000) to spare the relay; 0 switches right away
+
+typedef struct ventcontrol_stats_t
+{
+    uint32_t commands;
+    uint32_t batches;                   //Wake ups that took commands
+    uint32_t coalesced;                 //Speed changes overwritten by a later one of the same batch
+    uint32_t relay_changes;             //Times the relay switched
+    uint32_t requested_changes;         //Times it would have switched with every command applied on its own
+} ventcontrol_stats_t;
+
+//Hands a reply or publication to the server, the reference of the block goes with it
+typedef void (*ventcontrol_send_t)(message_t* message);
 
 void ventcontrol_task(void *params);
+uint64_t ventcontrol_initialize(uint64_t now);
+uint64_t ventcontrol_batch(message_t** batch, uint8_t count, uint64_t now, ventcontrol_send_t send);
+uint64_t ventcontrol_relay(uint64_t now);
+uint32_t ventcontrol_read_state(vent_state_t* state);
+void ventcontrol_get_stats(ventcontrol_stats_t* stats);
+void ventcontrol_print_stats(void);
 
 #endif /* C8EF045B_AAF1_4CEF_ACE5_68E90696899F */